@@ -0,0 +1,53 @@
+#include <iomanip>
+
+#include "context.h"
+
+#include "GRender/compression.h"
+
+// Loads a photo with its full mip chain as RGBA8 and as block compressed textures. First
+// compressed load decodes and encodes the image, writing the cache, next ones only read blocks
+// from disk. Memory is what the texture takes on the GPU.
+// Usage: CompressedTextures [image]
+
+using GRender::Texture;
+using Format = GRender::texture::Format;
+namespace fs = std::filesystem;
+
+static void report(const std::string& name, double time, size_t numBytes) {
+    std::cout << std::left << std::setw(16) << name << std::right << std::setw(12) << std::fixed
+              << std::setprecision(2) << time << " ms" << std::setw(12) << numBytes / double(1 << 20) << " MB\n";
+}
+
+int main(int argc, char** argv) {
+    const fs::path image = argc > 1 ? argv[1] : "example/assets/earth.jpg";
+    const fs::path cacheDirectory = fs::temp_directory_path() / "grender_benchmark_bc";
+    fs::remove_all(cacheDirectory);
+
+    benchmark::Context context;
+
+    std::cout << std::left << std::setw(16) << "Texture" << std::right << std::setw(15) << "Load"
+              << std::setw(15) << "Memory" << "\n";
+
+    GRender::texture::Specification spec;
+    spec.levels = 0;
+
+    Texture texture;
+    const double rgbaTime = benchmark::Measure([&]() { texture = GRender::utils::createTextureFromRGBAFile(image, spec); });
+    report("RGBA8", rgbaTime, texture.numBytes());
+
+    for (auto [name, fmt] : { std::pair{ "BC1", Format::BC1 }, { "BC3", Format::BC3 }, { "BC7", Format::BC7 } }) {
+        spec.fmt = fmt;
+        const double encodeTime = benchmark::Measure([&]() {
+            texture = GRender::utils::createCompressedTextureFromFile(image, cacheDirectory, spec);
+        });
+        report(std::string(name) + " encode", encodeTime, texture.numBytes());
+
+        const double cachedTime = benchmark::Measure([&]() {
+            texture = GRender::utils::createCompressedTextureFromFile(image, cacheDirectory, spec);
+        });
+        report(std::string(name) + " cached", cachedTime, texture.numBytes());
+    }
+
+    fs::remove_all(cacheDirectory);
+    return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "GRender/core.h"
+
+namespace benchmark {
+
+using Clock = std::chrono::steady_clock;
+
+// Creates a hidden window, so benchmarks can run without GRender::Application
+class Context {
+public:
+    Context(void) {
+        int success = glfwInit();
+        ASSERT(success, "(glfw) -> Couldn't start glfw!!!");
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 5);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        m_Window = glfwCreateWindow(64, 64, "benchmark", NULL, NULL);
+        ASSERT(m_Window, "(glfw) -> Failed to create GLFW window!!");
+
+        glfwMakeContextCurrent(m_Window);
+        success = gladLoadGL();
+        ASSERT(success, "(glad) -> Failed to initialize OpenGL loader!!!");
+
+        std::cout << "Renderer: " << glGetString(GL_RENDERER) << " (" << glGetString(GL_VERSION) << ")\n";
+    }
+
+    ~Context(void) {
+        glfwDestroyWindow(m_Window);
+        glfwTerminate();
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+private:
+    GLFWwindow* m_Window = nullptr;
+};
+
+// Returns elapsed milliseconds for running function
+template <typename FUNC>
+inline double Measure(FUNC&& function) {
+    auto t0 = Clock::now();
+    function();
+    glFinish();
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+} // namespace benchmark
@@ -0,0 +1,136 @@
+#include <iomanip>
+
+#include "context.h"
+
+#include "GRender/frameGraph.h"
+
+// Runs a chain of passes rendering into an imported viewport texture, checking culling, execution
+// order, reuse of pooled textures and that passes follow the viewport when it resizes. Reports
+// the CPU time spent building and executing the graph each frame.
+// Usage: FrameGraph [numFrames]
+//
+// Passes are declared out of order, and only copy and clear, so timings are dominated by the graph
+
+using GRender::Texture;
+using GRender::FrameGraph;
+namespace graph = GRender::graph;
+
+struct Checker {
+    bool passed = true;
+
+    void operator()(bool condition, const std::string& what) {
+        if (!condition) { std::cout << "FAILED: " << what << "\n"; }
+        passed &= condition;
+    }
+};
+
+static glm::u8vec4 pixel(const Texture& texture, const glm::uvec2& pos) {
+    const glm::uvec2 size = texture.size();
+    std::vector<glm::u8vec4> pixels(size.x * size.y);
+    glGetTextureImage(texture.id(), 0, GL_RGBA, GL_UNSIGNED_BYTE, int32_t(pixels.size() * sizeof(glm::u8vec4)), pixels.data());
+    return pixels[pos.y * size.x + pos.x];
+}
+
+static void copyTexel(const Texture& src, const Texture& dst) {
+    glCopyImageSubData(src.id(), GL_TEXTURE_2D, 0, 0, 0, 0, dst.id(), GL_TEXTURE_2D, 0, 0, 0, 0, 1, 1, 1);
+}
+
+// scene -> blur -> tonemap -> composite into viewport, plus a pass nobody reads
+static void buildFrame(FrameGraph& graph, const Texture& viewport, uint8_t value) {
+    const glm::uvec2 size = viewport.size();
+    graph::Handle output = graph.importTexture("viewport", viewport);
+    graph::Handle scene = graph.createTexture("scene", size);
+    graph::Handle blurred = graph.createTexture("blurred", size);
+    graph::Handle toned = graph.createTexture("toned", size);
+
+    graph.addPass("composite", [&](graph::Builder& builder) {
+        builder.read(toned, graph::Usage::TRANSFER);
+        builder.write(output, graph::Usage::ATTACHMENT);
+    }, [=](const graph::Resources& res) {
+        glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        copyTexel(res.texture(toned), res.texture(output));
+    });
+
+    graph.addPass("debug", [&](graph::Builder& builder) {
+        graph::Handle debug = builder.createTexture("debug", size);
+        builder.read(scene, graph::Usage::TRANSFER);
+        builder.write(debug, graph::Usage::ATTACHMENT);
+    }, [](const graph::Resources&) {
+        glClear(GL_COLOR_BUFFER_BIT);
+    });
+
+    graph.addPass("tonemap", [&](graph::Builder& builder) {
+        builder.read(blurred, graph::Usage::TRANSFER);
+        builder.write(toned, graph::Usage::TRANSFER);
+    }, [=](const graph::Resources& res) { copyTexel(res.texture(blurred), res.texture(toned)); });
+
+    graph.addPass("blur", [&](graph::Builder& builder) {
+        builder.read(scene, graph::Usage::TRANSFER);
+        builder.write(blurred, graph::Usage::TRANSFER);
+    }, [=](const graph::Resources& res) { copyTexel(res.texture(scene), res.texture(blurred)); });
+
+    graph.addPass("scene", [&](graph::Builder& builder) {
+        builder.write(scene, graph::Usage::ATTACHMENT);
+        builder.useDepth();
+    }, [=](const graph::Resources&) {
+        glClearColor(value / 255.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    });
+}
+
+// Runs one frame and checks its results. Default framebuffer is bound by the caller
+static void runFrame(FrameGraph& graph, const Texture& viewport, uint8_t value, Checker& check) {
+    buildFrame(graph, viewport, value);
+    graph.execute();
+
+    const std::string frame = " (value " + std::to_string(value) + ", size " + std::to_string(viewport.size().x) + "x" + std::to_string(viewport.size().y) + ")";
+
+    const std::vector<std::string> expected = { "scene", "blur", "tonemap", "composite" };
+    check(graph.executionOrder() == expected, "passes are culled and sorted" + frame);
+
+    int32_t bound = -1;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &bound);
+    check(bound == 0, "caller framebuffer is restored" + frame);
+
+    const glm::uvec2 last = viewport.size() - 1u;
+    check(pixel(viewport, { 0, 0 }) == glm::u8vec4(value, 0, 0, 255), "scene reaches the viewport" + frame);
+    check(pixel(viewport, last) == glm::u8vec4(0, 0, 255, 255), "composite renders into the viewport" + frame);
+}
+
+int main(int argc, char** argv) {
+    const uint32_t numFrames = argc > 1 ? std::stoul(argv[1]) : 1000;
+
+    benchmark::Context context;
+    Checker check;
+
+    FrameGraph graph;
+    Texture viewport({ 64, 64 });
+
+    // Toned reuses the scene texture, as their lifetimes don't overlap
+    runFrame(graph, viewport, 1, check);
+    check(graph.poolSize() == 2, "transient textures are aliased");
+
+    for (uint8_t value = 2; value < 8; value++) { runFrame(graph, viewport, value, check); }
+    check(graph.poolSize() == 2, "pool is reused across frames");
+
+    // Viewport gets the same id back, old framebuffers must not render into the deleted storage
+    viewport.resize({ 96, 48 });
+    runFrame(graph, viewport, 8, check);
+    check(graph.poolSize() == 4, "resized transients are allocated");
+
+    for (uint8_t value = 9; value < 16; value++) { runFrame(graph, viewport, value, check); }
+    check(graph.poolSize() == 2, "old size is released from the pool");
+
+    auto t0 = benchmark::Clock::now();
+    for (uint32_t k = 0; k < numFrames; k++) {
+        buildFrame(graph, viewport, uint8_t(k));
+        graph.execute();
+    }
+    glFinish();
+    const double elapsed = std::chrono::duration<double, std::milli>(benchmark::Clock::now() - t0).count();
+
+    std::cout << "Frame graph with 5 passes: " << std::fixed << std::setprecision(4) << elapsed / numFrames << " ms per frame\n";
+    std::cout << (check.passed ? "All checks passed" : "Some checks FAILED") << "\n";
+    return check.passed ? 0 : 1;
+}
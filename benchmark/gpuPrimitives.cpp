@@ -0,0 +1,221 @@
+#include <iomanip>
+#include <numeric>
+
+#include "context.h"
+
+#include "GRender/gpu.h"
+
+// Compares GPU primitives against their std:: counterparts, checking results against the CPU
+// reference implementations. GPU timings include only the kernels, not uploads or readbacks.
+// Ranges with offsets, in place scans and typed reductions are only checked. Any mismatch makes
+// the run fail.
+// Usage: GpuPrimitives [maxElements]
+
+using GRender::StorageBuffer;
+namespace gpu = GRender::gpu;
+
+static bool s_Passed = true;
+
+static void report(const std::string& name, size_t size, double gpuTime, double cpuTime, bool valid) {
+    s_Passed &= valid;
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(11) << size
+              << std::setw(12) << std::fixed << std::setprecision(3) << gpuTime << " ms"
+              << std::setw(12) << cpuTime << " ms"
+              << std::setw(9) << std::setprecision(2) << cpuTime / gpuTime << "x"
+              << (valid ? "" : "   MISMATCH") << "\n";
+}
+
+static void check(const std::string& name, size_t size, bool valid) {
+    s_Passed &= valid;
+    std::cout << std::left << std::setw(14) << name << std::right << std::setw(11) << size
+              << std::setw(49) << (valid ? "ok" : "MISMATCH") << "\n";
+}
+
+template <typename TP>
+static void checkReduce(const std::string& name, const std::vector<TP>& values) {
+    StorageBuffer input(values.size() * sizeof(TP), values.data());
+    for (auto [op, opName] : { std::pair{ gpu::Operation::MIN, " min" }, { gpu::Operation::MAX, " max" } }) {
+        check(name + opName, values.size(), gpu::reduce<TP>(input, values.size(), op) == gpu::cpu::reduce(values, op));
+    }
+}
+
+// Ranges start at different offsets inside larger buffers, whose borders must stay untouched
+static void checkOffsets(size_t size, const std::vector<uint32_t>& values, const std::vector<uint32_t>& keys, const std::vector<uint32_t>& flags) {
+    constexpr uint32_t BORDER = 0xDEADBEEF;
+    auto padded = [&](const std::vector<uint32_t>& data, size_t offset) {
+        std::vector<uint32_t> result(offset, BORDER);
+        result.insert(result.end(), data.begin(), data.end());
+        result.insert(result.end(), 3, BORDER);
+        return StorageBuffer(result.size() * sizeof(uint32_t), result.data());
+    };
+    auto slice = [&](const StorageBuffer& buffer, size_t offset) {
+        const std::vector<uint32_t> data = buffer.getBuffer<uint32_t>();
+        bool border = std::all_of(data.begin(), data.begin() + offset, [](uint32_t v) { return v == BORDER; });
+        border &= std::all_of(data.end() - 3, data.end(), [](uint32_t v) { return v == BORDER; });
+        return border ? std::vector<uint32_t>(data.begin() + offset, data.end() - 3) : std::vector<uint32_t>();
+    };
+    const std::vector<uint32_t> empty(size, 0);
+
+    {
+        StorageBuffer input(padded(values, 3)), output(padded(empty, 5));
+        gpu::exclusiveScan({ input, 3 * sizeof(uint32_t) }, { output, 5 * sizeof(uint32_t) }, size);
+        check("scan offset", size, slice(output, 5) == gpu::cpu::exclusiveScan(values));
+    }
+
+    {
+        StorageBuffer data(padded(values, 2));
+        gpu::exclusiveScan({ data, 2 * sizeof(uint32_t) }, { data, 2 * sizeof(uint32_t) }, size);
+        check("scan in place", size, slice(data, 2) == gpu::cpu::exclusiveScan(values));
+    }
+
+    {
+        StorageBuffer input(padded(values, 7)), result(padded({ 0 }, 1));
+        gpu::reduce({ input, 7 * sizeof(uint32_t) }, size, { result, sizeof(uint32_t) });
+        check("reduce offset", size, slice(result, 1) == std::vector<uint32_t>{ gpu::cpu::reduce(values) });
+    }
+
+    {
+        std::vector<uint32_t> indices(size);
+        std::iota(indices.begin(), indices.end(), 0u);
+
+        StorageBuffer gpuKeys(padded(keys, 1)), gpuValues(padded(indices, 6));
+        gpu::radixSortKeysValues({ gpuKeys, sizeof(uint32_t) }, { gpuValues, 6 * sizeof(uint32_t) }, size);
+
+        std::vector<uint32_t> refKeys = keys, refValues = indices;
+        gpu::cpu::radixSortKeysValues(refKeys, refValues);
+        check("sort offset", size, slice(gpuKeys, 1) == refKeys && slice(gpuValues, 6) == refValues);
+    }
+
+    {
+        StorageBuffer input(padded(keys, 1)), gpuFlags(padded(flags, 2)), output(padded(empty, 3)), counter(padded({ 0 }, 4));
+        gpu::compact({ input, sizeof(uint32_t) }, { gpuFlags, 2 * sizeof(uint32_t) }, { output, 3 * sizeof(uint32_t) },
+                     size, { counter, 4 * sizeof(uint32_t) });
+
+        std::vector<uint32_t> reference = gpu::cpu::compact(keys, flags);
+        const std::vector<uint32_t> kept = slice(output, 3);
+        const bool valid = slice(counter, 4) == std::vector<uint32_t>{ uint32_t(reference.size()) }
+                        && kept.size() == size && std::equal(reference.begin(), reference.end(), kept.begin());
+        check("compact offset", size, valid);
+    }
+}
+
+static void runSize(size_t size, std::mt19937& gen) {
+    std::uniform_int_distribution<uint32_t> small(0, 15), any;
+
+    std::vector<uint32_t> values(size), keys(size), flags(size);
+    for (size_t k = 0; k < size; k++) {
+        values[k] = small(gen);
+        keys[k] = any(gen);
+        flags[k] = values[k] % 2;
+    }
+    const size_t numBytes = size * sizeof(uint32_t);
+
+    // SCAN /////////////////////////////////////////////
+    {
+        StorageBuffer input(numBytes, values.data()), output(numBytes);
+        gpu::exclusiveScan(input, output, size); // warm up kernels and scratch buffers
+
+        const double gpuTime = benchmark::Measure([&]() { gpu::exclusiveScan(input, output, size); });
+
+        std::vector<uint32_t> reference(size);
+        const double cpuTime = benchmark::Measure([&]() { std::exclusive_scan(values.begin(), values.end(), reference.begin(), 0u); });
+
+        report("exclusiveScan", size, gpuTime, cpuTime, output.getBuffer<uint32_t>() == gpu::cpu::exclusiveScan(values));
+    }
+
+    // REDUCE ///////////////////////////////////////////
+    {
+        StorageBuffer input(numBytes, values.data()), result(sizeof(uint32_t));
+        gpu::reduce(input, size, result);
+
+        const double gpuTime = benchmark::Measure([&]() { gpu::reduce(input, size, result); });
+
+        uint32_t sum = 0;
+        const double cpuTime = benchmark::Measure([&]() { sum = std::reduce(values.begin(), values.end(), 0u); });
+
+        const bool valid = result.getBuffer<uint32_t>().front() == sum && sum == gpu::cpu::reduce(values);
+        report("reduce", size, gpuTime, cpuTime, valid);
+    }
+
+    // RADIX SORT ///////////////////////////////////////
+    {
+        std::vector<uint32_t> indices(size);
+        std::iota(indices.begin(), indices.end(), 0u);
+
+        StorageBuffer gpuKeys(numBytes, keys.data()), gpuValues(numBytes, indices.data());
+        gpu::radixSortKeysValues(gpuKeys, gpuValues, size);
+        gpuKeys.update(keys.data());
+        gpuValues.update(indices.data());
+
+        const double gpuTime = benchmark::Measure([&]() { gpu::radixSortKeysValues(gpuKeys, gpuValues, size); });
+
+        std::vector<std::pair<uint32_t, uint32_t>> pairs(size);
+        for (size_t k = 0; k < size; k++) { pairs[k] = { keys[k], indices[k] }; }
+        const double cpuTime = benchmark::Measure([&]() {
+            std::stable_sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        });
+
+        std::vector<uint32_t> refKeys = keys, refValues = indices;
+        gpu::cpu::radixSortKeysValues(refKeys, refValues);
+        const bool valid = gpuKeys.getBuffer<uint32_t>() == refKeys && gpuValues.getBuffer<uint32_t>() == refValues;
+        report("radixSort", size, gpuTime, cpuTime, valid);
+    }
+
+    // COMPACT //////////////////////////////////////////
+    // Any non-zero flag keeps, so flags up to 15 must give the same result as 0/1 ones
+    std::vector<uint32_t> wideFlags(size);
+    for (size_t k = 0; k < size; k++) { wideFlags[k] = flags[k] * values[k]; }
+
+    for (const auto& [name, kernelFlags] : { std::pair{ "compact", &flags }, { "compact wide", &wideFlags } }) {
+        StorageBuffer input(numBytes, keys.data()), gpuFlags(numBytes, kernelFlags->data());
+        StorageBuffer output(numBytes), counter(sizeof(uint32_t));
+        gpu::compact(input, gpuFlags, output, size, counter);
+
+        const double gpuTime = benchmark::Measure([&]() { gpu::compact(input, gpuFlags, output, size, counter); });
+
+        std::vector<uint32_t> kept;
+        kept.reserve(size);
+        const double cpuTime = benchmark::Measure([&]() {
+            for (size_t k = 0; k < size; k++) {
+                if ((*kernelFlags)[k]) { kept.push_back(keys[k]); }
+            }
+        });
+
+        const std::vector<uint32_t> reference = gpu::cpu::compact(keys, *kernelFlags);
+        const uint32_t numKept = counter.getBuffer<uint32_t>().front();
+        bool valid = numKept == reference.size();
+        if (valid && numKept > 0) { valid = output.getBuffer<uint32_t>(0, numKept) == reference; }
+        report(name, size, gpuTime, cpuTime, valid);
+    }
+
+    // CHECKS ///////////////////////////////////////////
+    std::uniform_int_distribution<int32_t> ints(-1'000'000, 1'000'000);
+    std::uniform_real_distribution<float> floats(-1000.0f, 1000.0f);
+    std::vector<int32_t> intValues(size);
+    std::vector<float> floatValues(size);
+    for (size_t k = 0; k < size; k++) {
+        intValues[k] = ints(gen);
+        floatValues[k] = floats(gen);
+    }
+    checkReduce("reduce int", intValues);
+    checkReduce("reduce float", floatValues);
+
+    checkOffsets(size, values, keys, flags);
+}
+
+int main(int argc, char** argv) {
+    const size_t maxElements = argc > 1 ? std::stoull(argv[1]) : 100'000'000;
+
+    benchmark::Context context;
+    std::mt19937 gen(42);
+
+    std::cout << std::left << std::setw(14) << "Primitive" << std::right << std::setw(11) << "Elements"
+              << std::setw(15) << "GPU" << std::setw(15) << "std::" << std::setw(10) << "Speedup" << "\n";
+
+    for (size_t size = 1000; size <= maxElements; size *= 10) {
+        runSize(size, gen);
+    }
+
+    std::cout << (s_Passed ? "All results match" : "Some results MISMATCH") << "\n";
+    return s_Passed ? 0 : 1;
+}
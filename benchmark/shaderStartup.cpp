@@ -0,0 +1,109 @@
+#include "context.h"
+
+#include "GRender/shader.h"
+#include "GRender/computeShader.h"
+
+// Measures how long it takes to create programs on a cold launch (compiling GLSL) against a
+// warm launch (loading binaries from the program cache).
+// Usage: ShaderStartup [numPrograms] [cacheDirectory]
+//
+// Drivers may have their own shader cache (e.g. Mesa), which hides the cost of cold launches.
+// Disable it for representative numbers, e.g. MESA_SHADER_CACHE_DISABLE=true
+
+constexpr std::string_view vertexShader =
+    "#version 450 core                                      \n"
+    "layout(location = 0) in vec3 position;                 \n"
+    "layout(location = 1) in vec4 color;                    \n"
+    "layout(location = 2) in vec2 texCoord;                 \n"
+    "layout(location = 3) in int  texID;                    \n"
+    "                                                       \n"
+    "uniform mat4 u_transform;                              \n"
+    "                                                       \n"
+    "out vec4 fColor;                                       \n"
+    "out vec2 fTexCoord;                                    \n"
+    "out flat int fTexID;                                   \n"
+    "                                                       \n"
+    "void main() {                                          \n"
+    "    fColor = color;                                    \n"
+    "    fTexCoord = texCoord;                              \n"
+    "    fTexID = texID;                                    \n"
+    "    gl_Position = u_transform * vec4(position, 1.0);   \n"
+    "}                                                      \n";
+
+constexpr std::string_view fragmentShader =
+    "#version 450 core                                                              \n"
+    "in vec4 fColor;                                                                \n"
+    "in vec2 fTexCoord;                                                             \n"
+    "in flat int fTexID;                                                            \n"
+    "                                                                               \n"
+    "uniform sampler2D texSampler[32];                                              \n"
+    "layout(location = 0) out vec4 outColor;                                        \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    vec3 color = fColor.rgb;                                                   \n"
+    "    if (fTexID >= 0) { color *= texture(texSampler[fTexID], fTexCoord).rgb; }  \n"
+    "    outColor = vec4(color, 1.0);                                               \n"
+    "}                                                                              \n";
+
+constexpr std::string_view computeShader =
+    "#version 430                                                                   \n"
+    "layout (local_size_x = 32, local_size_y = 32) in;                              \n"
+    "layout (rgba8, binding = 0) uniform image2D img_output;                        \n"
+    "uniform float time;                                                            \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    ivec2 coords = ivec2(gl_GlobalInvocationID);                               \n"
+    "    if (((gl_WorkGroupID.x & 1u) != 1u) != ((gl_WorkGroupID.y & 1u) == 1u)) {  \n"
+    "        imageStore(img_output, coords, vec4(0.0, abs(cos(time)), 0.0, 1.0));   \n"
+    "    } else {                                                                   \n"
+    "        imageStore(img_output, coords, vec4(1.0, 0.0, 0.0, 1.0));              \n"
+    "    }                                                                          \n"
+    "}                                                                              \n";
+
+// Creates numPrograms different render and compute programs. A comment makes every source unique,
+// so neither our cache nor the driver can share work between them.
+static double createPrograms(uint32_t numPrograms) {
+    std::vector<std::string> vtx, frg, cmp;
+    for (uint32_t k = 0; k < numPrograms; k++) {
+        const std::string tag = "// variant " + std::to_string(k) + "\n";
+        vtx.push_back(std::string(vertexShader) + tag);
+        frg.push_back(std::string(fragmentShader) + tag);
+        cmp.push_back(std::string(computeShader) + tag);
+    }
+
+    std::vector<GRender::Shader> shaders;
+    std::vector<GRender::ComputeShader> computes;
+    return benchmark::Measure([&]() {
+        for (uint32_t k = 0; k < numPrograms; k++) {
+            shaders.emplace_back(GRender::shader::Source{ vtx[k] }, GRender::shader::Source{ frg[k] });
+            computes.emplace_back(GRender::shader::Source{ cmp[k] });
+        }
+    });
+}
+
+int main(int argc, char** argv) {
+    namespace fs = std::filesystem;
+
+    const uint32_t numPrograms = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 16;
+    const fs::path cacheDir = argc > 2 ? fs::path(argv[2]) : fs::temp_directory_path() / "GRenderProgramCache";
+
+    benchmark::Context context;
+    fs::remove_all(cacheDir);
+
+    const double cold = createPrograms(numPrograms);
+
+    GRender::shader::EnableProgramCache(cacheDir);
+    const double store = createPrograms(numPrograms);
+    const double warm = createPrograms(numPrograms);
+    GRender::shader::DisableProgramCache();
+
+    const double total = 2.0 * numPrograms;
+    std::cout << "Programs created:         " << total << "\n"
+              << "Cold (no cache):          " << cold << " ms (" << cold / total << " ms/program)\n"
+              << "Cold (filling cache):     " << store << " ms (" << store / total << " ms/program)\n"
+              << "Warm (loading binaries):  " << warm << " ms (" << warm / total << " ms/program)\n"
+              << "Speedup:                  " << cold / warm << "x" << std::endl;
+
+    fs::remove_all(cacheDir);
+    return 0;
+}
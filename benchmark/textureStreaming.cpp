@@ -0,0 +1,135 @@
+#include <cstring>
+#include <deque>
+#include <iomanip>
+
+#include "context.h"
+
+#include "GRender/texture.h"
+
+// Pushes 4K frames into a texture every frame, as a video or camera feed would, comparing
+// Texture::update from client memory against TextureStream. Throughput counts bytes per second
+// sustained over all frames and latency is the time from submitting a frame until the GPU is done
+// with its upload.
+// Usage: TextureStreaming [numFrames]
+
+using GRender::Texture;
+using GRender::TextureStream;
+using Format = GRender::texture::Format;
+
+struct Result {
+    double throughput = 0.0;   // MB/s
+    double meanLatency = 0.0;  // ms
+    double maxLatency = 0.0;   // ms
+    uint64_t stalls = 0;
+};
+
+// Fences every submitted frame and collects latencies as they get signaled, without waiting
+class LatencyTracker {
+public:
+    void submitted(void) {
+        m_Queue.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), benchmark::Clock::now() });
+    }
+
+    void poll(bool wait = false) {
+        while (!m_Queue.empty()) {
+            auto& [fence, time] = m_Queue.front();
+            const GLuint64 timeout = wait ? 1'000'000'000 : 0;
+            if (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) == GL_TIMEOUT_EXPIRED) {
+                if (wait) { continue; }
+                return;
+            }
+
+            const double latency = std::chrono::duration<double, std::milli>(benchmark::Clock::now() - time).count();
+            m_Total += latency;
+            m_Max = std::max(m_Max, latency);
+            m_Count++;
+
+            glDeleteSync(fence);
+            m_Queue.pop_front();
+        }
+    }
+
+    void fill(Result& res) const {
+        res.meanLatency = m_Count ? m_Total / m_Count : 0.0;
+        res.maxLatency = m_Max;
+    }
+
+private:
+    std::deque<std::pair<GLsync, benchmark::Clock::time_point>> m_Queue;
+    double m_Total = 0.0, m_Max = 0.0;
+    uint64_t m_Count = 0;
+};
+
+template <typename FUNC>
+static Result run(uint32_t numFrames, size_t frameBytes, FUNC&& uploadFrame) {
+    LatencyTracker tracker;
+    Result res;
+
+    const double elapsed = benchmark::Measure([&]() {
+        for (uint32_t k = 0; k < numFrames; k++) {
+            uploadFrame(k);
+            tracker.submitted();
+            tracker.poll();
+        }
+    });
+    tracker.poll(true);
+
+    res.throughput = double(frameBytes) * numFrames / (1024.0 * 1024.0) / (elapsed * 1e-3);
+    tracker.fill(res);
+    return res;
+}
+
+static void report(const std::string& name, const Result& res) {
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed
+              << std::setw(10) << std::setprecision(1) << res.throughput << " MB/s"
+              << std::setw(10) << std::setprecision(3) << res.meanLatency << " ms"
+              << std::setw(10) << res.maxLatency << " ms"
+              << std::setw(8) << res.stalls << "\n";
+}
+
+static void runFormat(const std::string& name, Format fmt, size_t bytesPerPixel, uint32_t numFrames) {
+    const glm::uvec2 size = { 3840, 2160 };
+    const size_t frameBytes = size_t(size.x) * size.y * bytesPerPixel;
+
+    // Two different frames, so nothing is trivially cached
+    std::vector<std::vector<uint8_t>> frames(2, std::vector<uint8_t>(frameBytes));
+    std::mt19937 gen(42);
+    for (auto& frame : frames) {
+        std::generate(frame.begin(), frame.end(), [&]() { return static_cast<uint8_t>(gen()); });
+    }
+
+    GRender::texture::Specification spec;
+    spec.fmt = fmt;
+    Texture texture(size, spec);
+
+    // Warm up, so allocations are not measured
+    texture.update(frames[0].data());
+    glFinish();
+
+    Result direct = run(numFrames, frameBytes, [&](uint32_t k) { texture.update(frames[k % 2].data()); });
+    report(name + " update", direct);
+
+    for (uint32_t numBuffers : { 2u, 3u }) {
+        TextureStream stream(size, fmt, numBuffers);
+        Result res = run(numFrames, frameBytes, [&](uint32_t k) {
+            std::memcpy(stream.acquire(), frames[k % 2].data(), frameBytes);
+            stream.submit(texture);
+        });
+        res.stalls = stream.stalls();
+        report(name + " stream x" + std::to_string(numBuffers), res);
+    }
+}
+
+int main(int argc, char** argv) {
+    const uint32_t numFrames = argc > 1 ? std::stoul(argv[1]) : 300;
+
+    benchmark::Context context;
+
+    std::cout << std::left << std::setw(22) << "Upload" << std::right << std::setw(15) << "Throughput"
+              << std::setw(13) << "Latency" << std::setw(13) << "Max" << std::setw(8) << "Stalls" << "\n";
+
+    runFormat("RGBA8", Format::RGBA8, 4, numFrames);
+    runFormat("R32F", Format::FLOAT, 4, numFrames);
+
+    return 0;
+}
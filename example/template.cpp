@@ -7,10 +7,13 @@
 
 #include "GRender/camera.h"
 #include "GRender/computeShader.h"
+#include "GRender/frame.h"
 #include "GRender/interactiveImage.h"
 #include "GRender/orbitalCamera.h"
 #include "GRender/quad.h"
 #include "GRender/table.h"
+#include "GRender/textureCache.h"
+#include "GRender/textureLoader.h"
 #include "GRender/utils.h"
 #include "GRender/viewport.h"
 
@@ -60,6 +63,9 @@ private:
     GRender::Cylinder cylinder;
 
     GRender::Viewport view;
+    GRender::TextureLoader loader;
+    GRender::TextureCache cache{ 256ull << 20, &loader };
+    std::shared_ptr<GRender::Texture> earth;
     GRender::InteractiveImage interact;
 
     glm::vec3 bgColor = { 0.3f, 0.3f, 0.3f };
@@ -111,6 +117,11 @@ static void testTimer(bool* cancel, GRender::Timer* timer) {
 ///////////////////////////////////////////////////////////////////////////////
 
 Sandbox::Sandbox(const std::string& title) : Application(title, 1200, 800, "assets/layout.ini") {
+    // Reuses compiled programs from previous launches
+    GRender::shader::EnableProgramCache(fs::temp_directory_path() / "GRenderTemplate");
+    // Shaders compile in the background while we load the remaining assets
+    GRender::shader::EnableAsyncCompilation();
+
     compShader = GRender::ComputeShader(fs::path{ "assets/compute.cmp.glsl" });
 
     GRender::texture::Specification defSpec;
@@ -132,7 +143,13 @@ Sandbox::Sandbox(const std::string& title) : Application(title, 1200, 800, "asse
     spec.wrap.x = Wrap::MIRRORED;
     spec.wrap.y = Wrap::REPEAT;
     texture.insert("space", GRender::utils::createTextureFromRGBAFile("assets/space.jpg", spec));
-    texture.insert("earth", GRender::utils::createTextureFromRGBAFile("assets/earth.jpg", spec));
+
+    // Same earth texture for objects and interactive image, mipmapped to look fine zoomed out
+    Specification photo = spec;
+    photo.levels = 0;
+    photo.filter.min = Filter::LINEAR;
+    photo.filter.mipmap = Filter::LINEAR;
+    earth = cache.get("assets/earth.jpg", photo);
 
     spec.fmt = Format::RGBA8;
     spec.wrap.x = Wrap::BORDER;
@@ -142,12 +159,14 @@ Sandbox::Sandbox(const std::string& title) : Application(title, 1200, 800, "asse
     glEnable(GL_DEPTH_TEST);
     poly = polymer::Polymer(128, 1.0f);
 
-    interact = GRender::InteractiveImage("assets/earth.jpg");
+    interact = GRender::InteractiveImage(cache.get("assets/earth.jpg", photo));
 }
 
 void Sandbox::onUserUpdate(float deltaTime) {
     using namespace GRender;
 
+    loader.update();
+
     bool ctrl = keyboard::IsDown(Key::LEFT_CONTROL) || keyboard::IsDown(Key::RIGHT_CONTROL);
 
     if (ctrl && keyboard::IsPressed('H')) { view_specs = true; }
@@ -192,7 +211,10 @@ void Sandbox::onUserUpdate(float deltaTime) {
 
     ///////////////////////////////////////////////////////////////////////////
 
-    const glm::mat4& viewMatrix = useOrbitalCamera ? orbital.getViewMatrix() : camera.getViewMatrix();
+    // Camera matrices are shared by all draws in this frame
+    if (useOrbitalCamera) { orbital.upload(); }
+    else                  { camera.upload();  }
+    const glm::mat4 viewMatrix = frame::Current().viewProjection;
 
     view.bind();
 
@@ -211,7 +233,7 @@ void Sandbox::onUserUpdate(float deltaTime) {
     spec.texture = &texture["space"];
 
     quad.submit(spec);
-    quad.draw(viewMatrix);
+    quad.draw();
 
     ///////////////////////////////////////////////////////
     // POLYMER ////////////////////////////////////////////
@@ -222,7 +244,7 @@ void Sandbox::onUserUpdate(float deltaTime) {
     obj.position = {cos(tt), 7.0f + sin(tt), 0.0f };
     obj.rotation = { 0.0f, tt, 0.2f * tt };
     obj.scale.x = 1.0f + 0.7f * cos(tt);
-    obj.texture = &texture["earth"];
+    obj.texture = earth.get();
     cube.submit(obj);
 
     // SPHERE OF CUBES ////////////////////////////////////
@@ -258,16 +280,16 @@ void Sandbox::onUserUpdate(float deltaTime) {
     obj.position = com + osc * glm::vec3{0.0f, -0.5f, 0.0f};
     obj.color = {0.0f, 0.0f, 0.0f, 1.0f};
     cube.submit(obj);
-    cube.draw(viewMatrix);
+    cube.draw();
 
     // SPHERE ////////////////////////////////////////////////
     object::Specification obj2;
     obj2.position = { 7.0f, -5.0f, 0.0f };
     obj2.rotation = { 0.0f, -0.5f*tt, 0.0f };
     obj2.scale = glm::vec3{ 4.0f };
-    obj2.texture = &texture["earth"];
+    obj2.texture = earth.get();
     sphere.submit(obj2);
-    sphere.draw(viewMatrix);
+    sphere.draw();
 
     // CYLINDER ///////////////////////////////////////////
     object::Specification obj3;
@@ -276,7 +298,7 @@ void Sandbox::onUserUpdate(float deltaTime) {
     obj3.rotation = { tt, 0.5f*cos(tt), 0.5f * 3.1415f };
     obj3.texture = &texture["space"];
     cylinder.submit(obj3);
-    cylinder.draw(viewMatrix);
+    cylinder.draw();
 
     view.unbind();
 
@@ -284,13 +306,11 @@ void Sandbox::onUserUpdate(float deltaTime) {
     // COMPUTE SHADER /////////////////////////////////////
 
     const glm::uvec2  dimensions = texture["image"].size();
-    const uint32_t numGroupsX = dimensions.x / 32;
-    const uint32_t numGroupsY = dimensions.y / 32;
 
     compShader.bind();
     compShader.setUniform("time", tt);
-    compShader.setTexture(texture["image"]);
-    compShader.dispatch(numGroupsX, numGroupsY);
+    compShader.setTexture(texture["image"], 0, shader::Access::WRITE_ONLY);
+    compShader.dispatchThreads({ dimensions, 1 });
 }
 
 void Sandbox::ImGuiLayer(void) {
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <map>
+
+#include "core.h"
+#include "glState.h"
+#include "readback.h"
+
+namespace GRender {
+
+class BufferArena;
+
+// Part of a BufferArena, working as a small storage buffer. Memory returns to the arena on destruction
+class BufferSlice {
+public:
+    BufferSlice(void) = default;
+    ~BufferSlice(void);
+
+    // We should not copy GPU data
+    BufferSlice(const BufferSlice&) = delete;
+    BufferSlice& operator=(const BufferSlice&) = delete;
+    // But we can move slices around
+    BufferSlice(BufferSlice&&) noexcept;
+    BufferSlice& operator=(BufferSlice&&) noexcept;
+
+    // Backing buffer shared with other slices, and where this one starts in it
+    uint32_t id(void) const;
+    size_t offset(void) const { return m_Offset; }
+    size_t numBytes(void) const { return m_NumBytes; }
+
+    // Binds only this slice to indexed target, e.g. GL_UNIFORM_BUFFER
+    void bind(uint32_t location = 0, GLenum target = GL_SHADER_STORAGE_BUFFER) const;
+    // Offset and numBytes (default all) are relative to the slice
+    void update(const void* data, size_t offset = 0, size_t numBytes = 0);
+    Readback readAsync(size_t offset = 0, size_t numBytes = 0) const;
+
+    template <typename TP>
+    std::vector<TP> getBuffer(size_t offset = 0ul, size_t numElements = 0ul) const {
+        if (numElements == 0ul) { numElements = (m_NumBytes - offset) / sizeof(TP); }
+        ASSERT(offset + numElements * sizeof(TP) <= m_NumBytes, "Range is out of slice bounds!!");
+
+        std::vector<TP> vec(numElements);
+        gl::Consume(gl::Resource::BUFFER, id(), GL_BUFFER_UPDATE_BARRIER_BIT);
+        glGetNamedBufferSubData(id(), m_Offset + offset, numElements * sizeof(TP), vec.data());
+        return vec;
+    }
+
+    operator bool() const { return m_Arena != nullptr; }
+
+private:
+    friend class BufferArena;
+    BufferSlice(BufferArena* arena, size_t offset, size_t numBytes, size_t blockBytes)
+        : m_Arena(arena), m_Offset(offset), m_NumBytes(numBytes), m_BlockBytes(blockBytes) {}
+
+private:
+    BufferArena* m_Arena = nullptr;
+    size_t m_Offset = 0, m_NumBytes = 0;
+    size_t m_BlockBytes = 0; // numBytes rounded up to alignment, as reserved in the arena
+};
+
+// One large immutable buffer handing out many small slices. Fewer driver objects and a single
+// buffer to bind also open the way to multi-draw. Free blocks are kept sorted by offset, merged
+// with their neighbours when released and chosen with best fit.
+// Slices keep a pointer to their arena, so it cannot be moved and must outlive them.
+class BufferArena {
+public:
+    struct Statistics {
+        size_t capacity = 0;
+        size_t used = 0;         // bytes held by slices, including alignment padding
+        size_t largestFree = 0;  // biggest slice that can still be allocated
+        size_t numSlices = 0;
+        size_t numFreeBlocks = 0;
+
+        // Zero when all free memory is contiguous, close to one when it is scattered in small blocks
+        float fragmentation(void) const {
+            const size_t free = capacity - used;
+            return free == 0 ? 0.0f : 1.0f - float(largestFree) / float(free);
+        }
+    };
+
+public:
+    BufferArena(size_t capacity);
+    ~BufferArena(void);
+
+    BufferArena(const BufferArena&) = delete;
+    BufferArena& operator=(const BufferArena&) = delete;
+    BufferArena(BufferArena&&) = delete;
+    BufferArena& operator=(BufferArena&&) = delete;
+
+    uint32_t id(void) const { return m_BufferID; }
+    size_t capacity(void) const { return m_Capacity; }
+    // Slices start at multiples of this, valid for storage and uniform bindings
+    size_t alignment(void) const { return m_Alignment; }
+
+    // Returns an invalid slice if there is no free block large enough
+    BufferSlice allocate(size_t numBytes, const void* data = nullptr);
+
+    const Statistics& statistics(void) const { return m_Stats; }
+
+private:
+    friend class BufferSlice;
+    void release(size_t offset, size_t numBytes);
+
+private:
+    uint32_t m_BufferID = 0;
+    size_t m_Capacity = 0, m_Alignment = 1;
+    std::map<size_t, size_t> m_Free; // offset -> numBytes
+    Statistics m_Stats;
+};
+
+} // namespace GRender
@@ -18,9 +18,15 @@ public:
     void close(void);
 
     // Transformations
-    virtual glm::mat4 getViewMatrix(void);
+    virtual glm::mat4 getViewMatrix(void);   // projection * lookAt
+    virtual glm::mat4 getLookAtMatrix(void);
+    virtual glm::mat4 getProjectionMatrix(void);
+    virtual glm::vec3 getEyePosition(void);
     virtual void reset(void);
 
+    // Writes camera matrices into the shared frame data. Call it once per frame
+    void upload(void);
+
     // allows for automatic keyboard and mouse input handling
     virtual void controls(float deltaTime);
 
@@ -26,6 +26,11 @@ namespace GRender
         float& getSensitivity(void) { return sensitivity; }
 
         glm::mat4 getViewMatrix(void);
+        glm::mat4 getLookAtMatrix(void);
+        glm::mat4 getProjectionMatrix(void);
+
+        // Writes camera matrices into the shared frame data. Call it once per frame
+        void upload(void);
         float getZoom(void) const { return position.z; }
 
         void setAspectRatio(float value) { aspect = value; }
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core.h"
+
+#include "texture.h"
+
+// CPU encoders for block compressed formats and a small container storing compressed mip chains
+// on disk. Photos compressed once are then loaded by copying blocks straight into video memory,
+// skipping the image decoder, and use 4 (BC3, BC7) to 8 (BC1) times less memory than RGBA8.
+namespace GRender::compression {
+
+// Block compressed mip chain, level 0 first
+struct Image {
+    texture::Format fmt = texture::Format::NONE;
+    glm::uvec2 size = { 0, 0 };
+    std::vector<std::vector<uint8_t>> levels;
+};
+
+// Compresses RGBA8 pixels into BC1, BC3 or BC7 blocks on all available threads.
+// Sizes don't need to be multiple of 4, border blocks repeat edge texels
+std::vector<uint8_t> encode(const uint8_t* pixels, const glm::uvec2& size, texture::Format fmt);
+// Halves pixels with a box filter numLevels times (zero for the full chain) and compresses each level
+Image encodeMipChain(const uint8_t* pixels, const glm::uvec2& size, texture::Format fmt, uint32_t numLevels = 0);
+
+// Fingerprint of the file contents (FNV-1a), used to detect outdated compressed copies
+uint64_t hashFile(const fs::path& filepath);
+
+// Returns false if file can't be written
+bool save(const fs::path& filepath, const Image& image, uint64_t sourceHash);
+// Returns false if file is missing, corrupted or was compressed from a different source
+bool load(const fs::path& filepath, uint64_t sourceHash, Image& image);
+
+// Texture with all levels of image. Format and levels of spec are taken from image
+Texture createTexture(const Image& image, texture::Specification spec = texture::Specification());
+
+} // namespace GRender::compression
+
+namespace GRender::utils {
+
+// Same as createTextureFromRGBAFile, but compressed into spec.fmt. Compressed chain is stored in
+// cacheDirectory, named after the file hash, so next calls only read blocks from disk
+Texture createCompressedTextureFromFile(const fs::path& filepath, const fs::path& cacheDirectory, texture::Specification spec);
+
+} // namespace GRender::utils
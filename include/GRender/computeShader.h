@@ -8,7 +8,9 @@ class StorageBuffer;
 
 class ComputeShader {
 public:
-    ComputeShader(const std::filesystem::path& computePath);
+    ComputeShader(const std::filesystem::path& computePath, const shader::Defines& defines = {});
+    // Compiles GLSL code straight from memory, no files involved
+    ComputeShader(const shader::Source& compute, const shader::Defines& defines = {});
     ComputeShader(void) = default;
     ~ComputeShader();
 
@@ -22,19 +24,79 @@ public:
 
     const ComputeShader& bind();
 
+    // In asynchronous mode, checks without blocking if compilation has finished.
+    // Always true if driver lacks GL_KHR_parallel_shader_compile, see Program::isReady
+    bool isReady(void) const { return m_Program.isReady(); }
+
+    // Returns cached location of uniform. Use it to skip name lookups inside hot loops
+    shader::UniformHandle uniform(const std::string& name) const;
+
+    // std::vector and std::array are uploaded as uniform arrays in a single call
     template<typename TP>
     void setUniform(const std::string& name, const TP& value) const {
-        shader::internal::setUniform<TP>(m_ProgramID, name, value);
+        shader::internal::setUniform(uniform(name).location, value);
+    }
+
+    template<typename TP>
+    void setUniform(shader::UniformHandle handle, const TP& value) const {
+        shader::internal::setUniform(handle.location, value);
+    }
+
+    // Uploads count elements to an uniform array, starting from the element given by name
+    template<typename TP>
+    void setUniform(const std::string& name, const TP* values, size_t count) const {
+        shader::internal::setUniformArray<TP>(uniform(name).location, values, count);
+    }
+
+    template<typename TP>
+    void setUniform(shader::UniformHandle handle, const TP* values, size_t count) const {
+        shader::internal::setUniformArray<TP>(handle.location, values, count);
     }
 
-    void setTexture(const Texture& tex, uint32_t slot = 0) const;
-    void setBuffer(const StorageBuffer& buffer, uint32_t slot = 0) const;
+    // Lists active uniforms, attributes and storage blocks
+    shader::Reflection reflect(void) const { return m_Program.reflect(); }
+
+    // Binds texture level as image and buffer as storage block. Access is recorded for the next
+    // dispatch only, so barriers are issued just for its resources with pending writes. Set them
+    // again before every dispatch, otherwise writes of that dispatch are not tracked
+    void setTexture(const Texture& tex, uint32_t slot = 0, shader::Access access = shader::Access::READ_WRITE, uint32_t level = 0) const;
+    void setBuffer(const StorageBuffer& buffer, uint32_t slot = 0, shader::Access access = shader::Access::READ_WRITE) const;
 
     // Launch execution in GPU
     void dispatch(uint32_t numGroupsX, uint32_t numGroupsY = 1, uint32_t numGroupsZ = 1) const;
+    // Launches enough groups to cover numThreads, rounding up. Shader should discard extra threads
+    void dispatchThreads(const glm::uvec3& numThreads) const;
+    // Group counts are read by the GPU from three uints in args at offset, no CPU round trip
+    void dispatchIndirect(const StorageBuffer& args, size_t offset = 0) const;
+
+    // Local size declared in the shader
+    glm::uvec3 workGroupSize(void) const;
+
+private:
+    void waitForWrites(GLbitfield barriers) const;
+    void recordWrites(void) const;
 
 private:
-    uint32_t m_ProgramID = 0;
+    struct Binding {
+        uint32_t id;
+        shader::Access access;
+    };
+
+    shader::internal::Program m_Program;
+
+    // Resources by slot as set by the user, cleared after every dispatch
+    mutable std::map<uint32_t, Binding> m_Images, m_Buffers;
+    mutable glm::uvec3 m_GroupSize = { 0, 0, 0 };
 };
 
+namespace compute {
+
+// Writes indirect dispatch arguments { ceil(count / groupSize), 1, 1 } on the GPU, where count is
+// the uint at counterOffset in counter. Offsets are in bytes and must be multiples of 4.
+// It runs a small kernel, so it leaves its own program and storage slots 0 and 1 bound.
+void WriteDispatchArgs(const StorageBuffer& counter, size_t counterOffset,
+                       const StorageBuffer& args, size_t argsOffset, uint32_t groupSize);
+
+} // namespace compute
+
 } // namespace GRender
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core.h"
+
+namespace GRender::frame {
+
+// Uniform buffer binding point reserved for frame data
+constexpr uint32_t BINDING = 0;
+
+// Frame-global data shared by all built-in and user shaders. Layout follows std140
+struct Data {
+    glm::mat4 viewProjection{ 1.0f };
+    glm::mat4 view{ 1.0f };
+    glm::mat4 projection{ 1.0f };
+    glm::vec4 cameraPosition{ 0.0f, 0.0f, 0.0f, 1.0f };
+    glm::vec2 viewport{ 1.0f, 1.0f };
+    float time = 0.0f;
+    float deltaTime = 0.0f;
+};
+static_assert(sizeof(Data) == 224, "frame::Data must match std140 layout");
+
+// Block declaration matching Data. Shaders can paste it and read from u_Frame
+constexpr std::string_view GLSL =
+    "layout(std140, binding = 0) uniform FrameData {    \n"
+    "    mat4 viewProjection;                           \n"
+    "    mat4 view;                                     \n"
+    "    mat4 projection;                               \n"
+    "    vec4 cameraPosition;                           \n"
+    "    vec2 viewport;                                 \n"
+    "    float time;                                    \n"
+    "    float deltaTime;                               \n"
+    "} u_Frame;                                         \n";
+
+// Setters only modify a local copy. Data is sent to the GPU once by Upload
+void SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position);
+// Used by draw calls given only a combined matrix. Unless it matches the one from SetCamera, view
+// becomes identity, projection takes the whole matrix and camera position goes to the origin
+void SetViewProjection(const glm::mat4& viewProjection);
+void SetViewport(const glm::uvec2& size);
+void SetTime(float time, float deltaTime);
+
+const Data& Current(void);
+
+// Sends data to the uniform buffer if anything changed since last upload. Built-in renderers
+// call it before drawing; user shaders reading u_Frame should call it before dispatching work.
+void Upload(void);
+
+} // namespace GRender::frame
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <limits>
+#include <map>
+
+#include "core.h"
+
+#include "texture.h"
+#include "storageBuffer.h"
+
+namespace GRender {
+
+namespace graph {
+
+// Reference to a texture or buffer declared in the graph. Only valid for the current frame
+struct Handle {
+    uint32_t index = std::numeric_limits<uint32_t>::max();
+
+    operator bool() const { return index != std::numeric_limits<uint32_t>::max(); }
+};
+
+// How a pass touches a resource. It decides which memory barrier is needed when the resource
+// was written by shader stores in a previous pass.
+enum class Usage : uint8_t {
+    SAMPLED,    // texture fetches, e.g. Shader::setTexture
+    IMAGE,      // image load/store, e.g. ComputeShader::setTexture
+    STORAGE,    // storage blocks, e.g. ComputeShader::setBuffer
+    ATTACHMENT, // color attachment of the pass framebuffer
+    INDIRECT,   // arguments for ComputeShader::dispatchIndirect
+    TRANSFER    // CPU updates and readbacks
+};
+
+class Builder;
+class Resources;
+
+} // namespace graph
+
+// Passes declare which textures and buffers they read and write. Every frame the graph orders
+// passes following their dependencies, culls the ones whose results are never used and issues
+// only the memory barriers needed between them.
+// Transient resources are taken from a pool owned by the graph. Resources with compatible
+// specification are reused by passes whose lifetimes don't overlap and unused ones are released
+// after a few frames, e.g. when a viewport resizes.
+//
+// Usage, once per frame:
+//     graph.addPass("blur", [&](graph::Builder& builder) { ... }, [=](const graph::Resources& res) { ... });
+//     graph.execute();
+class FrameGraph {
+public:
+    using Setup = std::function<void(graph::Builder&)>;
+    using Execute = std::function<void(const graph::Resources&)>;
+
+    FrameGraph(void) = default;
+    ~FrameGraph(void);
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    FrameGraph(FrameGraph&&) noexcept = default;
+    FrameGraph& operator=(FrameGraph&&) noexcept = default;
+
+    // External resources live outside the graph. Passes writing them are never culled
+    graph::Handle importTexture(const std::string& name, const Texture& texture);
+    graph::Handle importBuffer(const std::string& name, const StorageBuffer& buffer);
+
+    // Transient resources, allocated from the pool only while needed. Declaring them up front
+    // allows passes to be added in any order
+    graph::Handle createTexture(const std::string& name, const glm::uvec2& size, const texture::Specification& spec = {});
+    graph::Handle createBuffer(const std::string& name, size_t numBytes);
+
+    // Setup runs immediately and declares resources. Execute runs later, in graph order.
+    // First declaration after execute starts a new frame, invalidating previous handles
+    void addPass(const std::string& name, const Setup& setup, const Execute& execute);
+
+    // Keeps passes producing this resource alive, e.g. transient texture displayed by ImGui
+    void markOutput(graph::Handle handle);
+
+    // Runs all required passes. Pooled resources are kept for the next frames
+    void execute(void);
+
+    // Name of executed passes in order, for debugging
+    const std::vector<std::string>& executionOrder(void) const { return m_Order; }
+    // Number of textures and buffers currently in the pool
+    size_t poolSize(void) const { return m_TexturePool.size() + m_BufferPool.size(); }
+
+    // Resources of the last executed frame, e.g. outputs to be displayed. Returns nullptr if culled
+    const Texture* texture(graph::Handle handle) const;
+    const StorageBuffer* buffer(graph::Handle handle) const;
+
+private:
+    friend class graph::Builder;
+    friend class graph::Resources;
+
+    struct Access {
+        uint32_t resource;
+        graph::Usage usage;
+        bool write;
+    };
+
+    struct Pass {
+        std::string name;
+        Execute execute;
+        std::vector<Access> accesses;
+        bool sideEffect = false, depth = false;
+    };
+
+    struct Resource {
+        std::string name;
+        bool isTexture = true, imported = false, output = false;
+
+        // Transient description
+        glm::uvec2 size = { 0, 0 };
+        texture::Specification spec;
+        size_t numBytes = 0;
+
+        // Filled during execution
+        const Texture* texture = nullptr;
+        const StorageBuffer* buffer = nullptr;
+    };
+
+    template <typename TP>
+    struct PoolEntry {
+        TP object;
+        bool inUse = false;
+        uint64_t lastFrame = 0;
+    };
+
+    struct Target {
+        uint32_t framebuffer = 0, depth = 0;
+        glm::uvec2 size = { 0, 0 }; // of depth buffer
+        uint64_t lastFrame = 0;
+    };
+
+    void beginFrame(void);
+    std::vector<uint32_t> schedule(void) const;
+    void acquire(Resource& res);
+    void release(Resource& res);
+    void bindTarget(const Pass& pass);
+    void collectGarbage(void);
+
+private:
+    std::vector<Pass> m_Passes;
+    std::vector<Resource> m_Resources;
+    std::vector<std::string> m_Order;
+
+    std::list<PoolEntry<Texture>> m_TexturePool;
+    std::list<PoolEntry<StorageBuffer>> m_BufferPool;
+    std::map<std::vector<uint32_t>, Target> m_Targets; // framebuffers by attachments and depth flag
+    uint64_t m_Frame = 0;
+    bool m_Executed = false;
+};
+
+namespace graph {
+
+// Used inside setup to declare resources and how the pass uses them
+class Builder {
+public:
+    // Same as FrameGraph::createTexture and FrameGraph::createBuffer
+    Handle createTexture(const std::string& name, const glm::uvec2& size, const texture::Specification& spec = {});
+    Handle createBuffer(const std::string& name, size_t numBytes);
+
+    Handle read(Handle handle, Usage usage);
+    Handle write(Handle handle, Usage usage);
+
+    // Pass framebuffer gets a depth buffer, sized as the attachments
+    void useDepth(void);
+    // Pass is never culled, e.g. it copies results to the CPU
+    void sideEffect(void);
+
+private:
+    Builder(FrameGraph& graph, FrameGraph::Pass& pass) : m_Graph(graph), m_Pass(pass) {}
+    friend class GRender::FrameGraph;
+
+    FrameGraph& m_Graph;
+    FrameGraph::Pass& m_Pass;
+};
+
+// Given to passes during execution. Attachments are already bound
+class Resources {
+public:
+    const Texture& texture(Handle handle) const;
+    const StorageBuffer& buffer(Handle handle) const;
+
+private:
+    Resources(const FrameGraph& graph) : m_Graph(graph) {}
+    friend class GRender::FrameGraph;
+
+    const FrameGraph& m_Graph;
+};
+
+} // namespace graph
+
+} // namespace GRender
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core.h"
+
+// Tracks the OpenGL bindings issued by GRender, so redundant calls never reach the driver.
+// Every wrapper in this library binds through here. External code that changes GL state
+// (e.g. ImGui rendering) must be followed by Invalidate, which Application does every frame.
+namespace GRender::gl {
+
+struct Statistics {
+    uint64_t issued = 0;   // calls sent to the driver
+    uint64_t skipped = 0;  // redundant calls filtered out
+    uint64_t barriers = 0; // memory barriers sent to the driver
+};
+
+void UseProgram(uint32_t program);
+void BindVertexArray(uint32_t vao);
+void BindFramebuffer(uint32_t framebuffer);
+void Viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+// Current bindings, asking the driver only if the cache doesn't know them, e.g. to restore them later
+uint32_t CurrentFramebuffer(void);
+glm::ivec4 CurrentViewport(void);
+
+// Generic binding points, e.g. GL_ARRAY_BUFFER. Element buffers are tracked per vertex array
+void BindBuffer(GLenum target, uint32_t buffer);
+// Indexed binding points for GL_SHADER_STORAGE_BUFFER and GL_UNIFORM_BUFFER
+void BindBufferBase(GLenum target, uint32_t index, uint32_t buffer);
+void BindBufferRange(GLenum target, uint32_t index, uint32_t buffer, GLintptr offset, GLsizeiptr size);
+
+// Binds texture to texture unit without touching the active unit
+void BindTexture(uint32_t unit, uint32_t texture);
+void BindImageTexture(uint32_t unit, uint32_t texture, int32_t level, bool layered, int32_t layer, GLenum access, GLenum format);
+
+// Image stores and storage buffer writes are incoherent. Writers mark the resources they
+// touched, and consumers ask for the barrier matching how they read it, e.g.
+// GL_TEXTURE_FETCH_BARRIER_BIT for sampling. Barriers are only issued if some write
+// happened after the last barrier with the same bits.
+enum class Resource { TEXTURE, BUFFER };
+
+void MarkWritten(Resource type, uint32_t id);
+// Returns the subset of barriers still needed before reading id
+GLbitfield PendingBarriers(Resource type, uint32_t id, GLbitfield barriers);
+// Issues barriers and records them, zero is ignored
+void IssueBarriers(GLbitfield barriers);
+// Shortcut for IssueBarriers(PendingBarriers(type, id, barriers))
+void Consume(Resource type, uint32_t id, GLbitfield barriers);
+// Issues barriers only if any resource was written after them, e.g. before ImGui samples textures
+void FlushBarriers(GLbitfield barriers = GL_ALL_BARRIER_BITS);
+
+// Blocks until fence is signaled and deletes it. Returns true if the GPU wasn't done yet, i.e.
+// the caller stalled. Commands are flushed while waiting, so the fence is always reached
+bool WaitFence(GLsync fence);
+
+// Deleted names are reused by OpenGL, so they must be removed from the cache
+void DeleteProgram(uint32_t program);
+void DeleteVertexArray(uint32_t vao);
+void DeleteFramebuffer(uint32_t framebuffer);
+void DeleteBuffer(uint32_t buffer);
+void DeleteTexture(uint32_t texture);
+
+// Forgets everything we know about the current state, so next calls are always issued
+void Invalidate(void);
+
+Statistics GetStatistics(void);
+void ResetStatistics(void);
+
+} // namespace GRender::gl
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "core.h"
+
+#include "storageBuffer.h"
+
+// Parallel primitives running on compute shaders. They work on 32 bits elements stored in
+// storage buffers, take care of barriers between their own passes and leave results on the GPU.
+// Kernels are compiled the first time they are needed and leave their program and storage
+// slots 0 to 4 bound, so callers must bind their own shaders and buffers again afterwards.
+namespace GRender::gpu {
+
+// Elements inside a storage buffer, starting at offset in bytes (multiple of 4)
+struct Range {
+    Range(const StorageBuffer& buffer, size_t offset = 0) : buffer(&buffer), offset(offset) {}
+
+    const StorageBuffer* buffer;
+    size_t offset;
+};
+
+enum class Operation : uint8_t { SUM, MIN, MAX };
+enum class Type : uint8_t { UINT, INT, FLOAT };
+
+// output[k] = input[0] + ... + input[k-1] for uint elements. Input and output may be the same range
+void exclusiveScan(Range input, Range output, size_t count);
+
+// Writes a single element combining count elements into result
+void reduce(Range input, size_t count, Range result, Operation op = Operation::SUM, Type type = Type::UINT);
+// Same as above, but it reads result back, so it waits for the GPU. TP is uint32_t, int32_t or float
+template <typename TP>
+TP reduce(Range input, size_t count, Operation op = Operation::SUM);
+
+// Stable ascending sort of uint keys, moving values along. Keys and values may start at different offsets
+void radixSortKeysValues(Range keys, Range values, size_t count);
+void radixSortKeys(Range keys, size_t count);
+
+// Copies input elements with non-zero flags to output, keeping their order.
+// Number of copied elements is written as uint into counter, ready for compute::WriteDispatchArgs
+void compact(Range input, Range flags, Range output, size_t count, Range counter);
+
+// Reference implementations used to validate results
+namespace cpu {
+std::vector<uint32_t> exclusiveScan(const std::vector<uint32_t>& input);
+template <typename TP>
+TP reduce(const std::vector<TP>& input, Operation op = Operation::SUM);
+void radixSortKeysValues(std::vector<uint32_t>& keys, std::vector<uint32_t>& values);
+std::vector<uint32_t> compact(const std::vector<uint32_t>& input, const std::vector<uint32_t>& flags);
+} // namespace cpu
+
+} // namespace GRender::gpu
@@ -5,15 +5,21 @@
 
 namespace GRender {
 
+class TextureLoader;
+
 class InteractiveImage {
 public:
 	InteractiveImage(const glm::uvec2& size, const texture::Specification& spec = texture::Specification(), const void* data = nullptr);
 	InteractiveImage(const fs::path& filepath);
+	// Shows a placeholder until loader uploads the file
+	InteractiveImage(const fs::path& filepath, TextureLoader& loader);
+	// Texture can be shared with other images, e.g. while it's still loading
+	InteractiveImage(std::shared_ptr<Texture> texture);
 	InteractiveImage(void) = default;
 	~InteractiveImage(void) = default;
 
-	Texture& texture() { return m_Texture; }
-	const Texture& texture() const { return m_Texture; }
+	Texture& texture() { return *m_Texture; }
+	const Texture& texture() const { return *m_Texture; }
 
 	// We don't want it to be copied
 	InteractiveImage(const InteractiveImage&) = delete;
@@ -46,7 +52,7 @@ private:
 	glm::vec2 m_PosMin = {0.0f, 0.0f};
 	glm::vec2 m_PosMax = {1.0f, 1.0f};
 
-	Texture m_Texture;
+	std::shared_ptr<Texture> m_Texture = std::make_shared<Texture>();
 };
 
 } // namespace GRender
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core.h"
+
+#include "texture.h"
+
+namespace GRender {
+
+namespace material {
+// Layer of a texture array owned by a MaterialLibrary
+struct Handle {
+    const TextureArray* array = nullptr;
+    uint32_t layer = 0;
+
+    operator bool() const { return array != nullptr; }
+};
+} // namespace material
+
+// Packs images into texture arrays, one group of arrays per size and format, so Quad and Object
+// can draw thousands of distinct images with a single draw call per array. Arrays are created as
+// previous ones fill up and all of them share the filtering options of the library specification.
+// Mipmaps of an array are generated once when it is next drawn, so adding many images stays cheap.
+//
+// Usage:
+//     MaterialLibrary library(spec);
+//     quad::Specification sprite;
+//     sprite.material = library.add(texture);
+class MaterialLibrary {
+public:
+    MaterialLibrary(const texture::Specification& spec = texture::Specification(), uint32_t layersPerArray = 256);
+
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+    // Arrays don't move in memory, so handles stay valid
+    MaterialLibrary(MaterialLibrary&&) noexcept = default;
+    MaterialLibrary& operator=(MaterialLibrary&&) noexcept = default;
+
+    // Uploads image with format from library specification
+    material::Handle add(const glm::uvec2& size, const void* data);
+    // Copies texture on the GPU into a new layer. Keep the handle, adding it again takes another layer
+    material::Handle add(const Texture& texture);
+
+    // New contents for a layer, same size and format as before
+    void update(material::Handle handle, const void* data);
+    // Copies texture into handle layer again, e.g. after it was updated
+    void update(material::Handle handle, const Texture& texture);
+
+    size_t numArrays(void) const { return m_Arrays.size(); }
+    size_t numMaterials(void) const;
+
+private:
+    material::Handle allocate(const glm::uvec2& size, texture::Format fmt);
+    TextureArray& mutableArray(material::Handle handle);
+
+private:
+    struct Entry {
+        TextureArray array;
+        uint32_t used = 0;
+    };
+
+    texture::Specification m_Spec;
+    uint32_t m_LayersPerArray = 0;
+    std::list<Entry> m_Arrays;
+};
+
+} // namespace GRender
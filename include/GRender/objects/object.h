@@ -4,6 +4,9 @@
 
 #include "GRender/shader.h"
 #include "GRender/texture.h"
+#include "GRender/material.h"
+#include "GRender/typedStorageBuffer.h"
+
 namespace GRender {
 
 namespace object {
@@ -17,8 +20,38 @@ struct Specification {
     glm::vec3 position{0.0f};
     glm::vec3 rotation{0.0f};
     glm::vec3 scale{1.0f};
+
+    // Either a texture or a layer from a material library, which takes precedence
     Texture* texture = nullptr;
+    material::Handle material;
+};
+
+// Instance layout read by Object::drawFromBuffer, matching this GLSL std430 struct:
+//     struct Instance {
+//         vec3 position; int layer;
+//         vec3 rotation; float padding0;
+//         vec3 scale;    float padding1;
+//         vec4 color;
+//     };
+//     layout(std430) buffer Instances { Instance instances[]; };
+struct Instance {
+    glm::vec3 position{ 0.0f };
+    // Layer of the texture array given for drawing, or -1 for plain colors
+    int32_t layer = -1;
+    glm::vec3 rotation{ 0.0f };
+    float padding0 = 0.0f;
+    glm::vec3 scale{ 1.0f };
+    float padding1 = 0.0f;
+    glm::vec4 color{ 1.0f };
 };
+STD430_OFFSET(Instance, layer, 12);
+STD430_OFFSET(Instance, rotation, 16);
+STD430_OFFSET(Instance, scale, 32);
+STD430_OFFSET(Instance, color, 48);
+STD430_SIZE(Instance, 64);
+
+// Storage block binding used by drawFromBuffer
+constexpr uint32_t INSTANCE_BINDING = 0;
 
 } // namespace object
 
@@ -37,10 +70,19 @@ public:
     Object(const Object&) noexcept = delete;
     Object& operator=(const Object*) noexcept = delete;
 
-    // Submit object into buffer for drawing
+    // Submit object into buffer for drawing. Consecutive objects sharing a texture, or a material
+    // array, are drawn by the same call, so materials let many images share one draw call
     void submit(const object::Specification& specs);
     // Draws all objects present in buffer. Please provide view matrix for camera used.
     void draw(const glm::mat4& viewMatrix);
+    // Draws using the matrices a camera uploaded into the frame data
+    void draw(void);
+
+    // Draws count instances stored in a GPU buffer following object::Instance layout, e.g. written
+    // by a compute shader. Submitted objects are left untouched and nothing is copied to the GPU
+    void drawFromBuffer(const StorageBuffer& instances, uint32_t count, const glm::mat4& viewMatrix,
+                        const TextureArray* materials = nullptr);
+    void drawFromBuffer(const StorageBuffer& instances, uint32_t count, const TextureArray* materials = nullptr);
 
 protected:
     void initialize(const std::vector<object::Vertex>& vtxBuffer,
@@ -49,17 +91,24 @@ protected:
 private:
     uint32_t m_MaxNumber = 0;
     uint32_t m_VAO = 0, m_VTX = 0, m_IDX = 0;
+    uint32_t m_PullVAO = 0; // only mesh attributes, instances come from storage buffers
     uint32_t m_POS = 0, m_ROT = 0, m_SCL = 0, m_CLR = 0, m_TEX = 0;
 
     GLsizei m_NumIndices = 0;
     std::vector<glm::vec3> m_Position, m_Rotation, m_Scale;
     std::vector<glm::vec4> m_Color;
-    std::vector<int32_t> m_Texture;
-
-    std::unordered_map<Texture*, int32_t> m_TextureMap;
-
-    // A common shader for all objects
-    static std::unique_ptr<Shader> m_Shader;
+    std::vector<int32_t> m_Layer;
+
+    // Run of consecutive objects sampling the same texture or array
+    struct Batch {
+        const Texture* texture = nullptr;
+        const TextureArray* array = nullptr;
+        uint32_t first = 0, count = 0;
+    };
+    std::vector<Batch> m_Batches;
+
+    // A common set of shader variants for all objects
+    static std::unique_ptr<ShaderVariants> m_Shader;
 };
 
 } //namespace GRender
@@ -16,7 +16,8 @@ public:
     void display(void) override;
     
     // Transformations
-    glm::mat4 getViewMatrix(void) override;
+    glm::mat4 getLookAtMatrix(void) override;
+    glm::vec3 getEyePosition(void) override;
     void reset(void) override;
 
     // allows for automatic keyboard and mouse input handling
@@ -5,6 +5,7 @@
 
 #include "shader.h"
 #include "texture.h"
+#include "material.h"
 
 namespace GRender {
     
@@ -16,14 +17,16 @@ struct Specification {
     glm::vec2 size     = { 1.0f, 1.0f };
     float angle        = 0.0f;
     
+    // Either a texture or a layer from a material library, which takes precedence
     Texture* texture = nullptr;
+    material::Handle material;
 };
 
 struct Vertex {
     glm::vec3 pos;
     glm::vec4 color;
     glm::vec2 texCoord;
-    int texID;
+    int layer; // inside material texture array
 };
 } // namespace quad
 
@@ -40,10 +43,13 @@ public:
     Quad(Quad&&) noexcept;
     Quad& operator=(Quad&&) noexcept;
 
-    // Insert a quad into the buffer for drawing
+    // Insert a quad into the buffer for drawing. Consecutive quads sharing a texture, or a material
+    // array, are drawn by the same call, so materials let many images share one draw call
     void submit(const quad::Specification& spec = quad::Specification());
-    // Draws all quads in buffer at once. Depending on camera used, a view matrix shall be provided
+    // Draws all quads in buffer in submission order. Depending on camera used, a view matrix shall be provided
     void draw(const glm::mat4& viewMatrix);
+    // Draws using the matrices a camera uploaded into the frame data
+    void draw(void);
 
 private:
     uint32_t
@@ -52,12 +58,19 @@ private:
         idxBuffer = 0,
         maxVertices = 0;
 
+    // Run of consecutive quads sampling the same texture or array
+    struct Batch {
+        const Texture* texture = nullptr;
+        const TextureArray* array = nullptr;
+        uint32_t first = 0, count = 0;
+    };
+
     std::vector<uint32_t> vID;
     std::vector<quad::Vertex> vertices;
-    std::unordered_map<Texture*, int32_t> m_TextureMap;
+    std::vector<Batch> m_Batches;
 
-    // A single shader instance for all quad objects
-    static std::unique_ptr<Shader> m_Shader;
+    // A single set of shader variants for all quad objects
+    static std::unique_ptr<ShaderVariants> m_Shader;
 
 };
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "core.h"
+
+namespace GRender {
+
+// Copy of GPU data on its way back to the CPU. The copy is queued together with a fence, so
+// nothing stalls until results are accessed. Poll ready() every frame, or keep the readback
+// around for a couple of frames, and then read the data straight from mapped memory.
+//
+// Usage:
+//     Readback stats = buffer.readAsync();
+//     ...
+//     if (stats.ready()) { const uint32_t* values = stats.data<uint32_t>(); }
+class Readback {
+public:
+    Readback(void) = default;
+    ~Readback(void);
+
+    // We should not copy GPU data
+    Readback(const Readback&) = delete;
+    Readback& operator=(const Readback&) = delete;
+    // But we can move IDs around
+    Readback(Readback&&) noexcept;
+    Readback& operator=(Readback&&) noexcept;
+
+    size_t numBytes(void) const { return m_NumBytes; }
+
+    // True once the GPU finished the copy. Never blocks
+    bool ready(void) const;
+    // Blocks until the copy is finished
+    void wait(void) const;
+
+    // Mapped results, only valid while this readback lives. Waits if copy is not finished yet
+    template <typename TP>
+    const TP* data(void) const { return static_cast<const TP*>(map()); }
+
+    // Same as above, but copies results into a vector
+    template <typename TP>
+    std::vector<TP> get(void) const {
+        const TP* ptr = data<TP>();
+        return std::vector<TP>(ptr, ptr + m_NumBytes / sizeof(TP));
+    }
+
+    operator bool() const { return m_BufferID > 0; }
+
+private:
+    friend class StorageBuffer;
+    friend class BufferSlice;
+    friend class Texture;
+
+    // Staging buffer receiving the copy. Owner must queue its copy and then call fence()
+    Readback(size_t numBytes);
+    void fence(void);
+    const void* map(void) const;
+
+private:
+    uint32_t m_BufferID = 0;
+    size_t m_NumBytes = 0;
+    mutable GLsync m_Fence = nullptr;
+    mutable void* m_Mapped = nullptr;
+};
+
+} // namespace GRender
@@ -6,11 +6,14 @@
 
 namespace GRender {
 class Texture;
+class TextureArray;
 class StorageBuffer;
 
 class Shader {
 public:
-    Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath);
+    Shader(const std::filesystem::path& vertexPath, const std::filesystem::path& fragmentPath, const shader::Defines& defines = {});
+    // Compiles GLSL code straight from memory, no files involved
+    Shader(const shader::Source& vertex, const shader::Source& fragment, const shader::Defines& defines = {});
     Shader(void) = default;
     ~Shader(void);
 
@@ -25,17 +28,67 @@ public:
     // Return a reference to current object for easier handling
     const Shader& bind(void);
 
+    // In asynchronous mode, checks without blocking if compilation has finished.
+    // Always true if driver lacks GL_KHR_parallel_shader_compile, see Program::isReady
+    bool isReady(void) const { return m_Program.isReady(); }
+
+    // Returns cached location of uniform. Use it to skip name lookups inside hot loops
+    shader::UniformHandle uniform(const std::string& name) const;
+
     // A set of uniforms predefined by OpenGL.
+    // std::vector and std::array are uploaded as uniform arrays in a single call
     template<typename TP>
     void setUniform(const std::string& name, const TP& value) const {
-        shader::internal::setUniform<TP>(m_ProgramID, name, value);
+        shader::internal::setUniform(uniform(name).location, value);
+    }
+
+    template<typename TP>
+    void setUniform(shader::UniformHandle handle, const TP& value) const {
+        shader::internal::setUniform(handle.location, value);
+    }
+
+    // Uploads count elements to an uniform array, starting from the element given by name
+    template<typename TP>
+    void setUniform(const std::string& name, const TP* values, size_t count) const {
+        shader::internal::setUniformArray<TP>(uniform(name).location, values, count);
+    }
+
+    template<typename TP>
+    void setUniform(shader::UniformHandle handle, const TP* values, size_t count) const {
+        shader::internal::setUniformArray<TP>(handle.location, values, count);
     }
 
+    // Lists active uniforms, attributes and storage blocks
+    shader::Reflection reflect(void) const { return m_Program.reflect(); }
+
     // Sends texture to GPU at set slot
     void setTexture(const Texture& tex, uint32_t slot = 0) const;
+    void setTexture(const TextureArray& tex, uint32_t slot = 0) const;
+
+private:
+    shader::internal::Program m_Program;
+};
+
+// Compiles specialized versions of the same sources on demand, e.g. with and without textures.
+// Each combination of defines is compiled once and kept, so renderers can cheaply pick the
+// variant matching the contents of each batch.
+class ShaderVariants {
+public:
+    ShaderVariants(const shader::Source& vertex, const shader::Source& fragment);
+    ShaderVariants(void) = default;
+    ~ShaderVariants(void) = default;
+
+    ShaderVariants(const ShaderVariants&) = delete;
+    ShaderVariants& operator=(const ShaderVariants&) = delete;
+
+    ShaderVariants(ShaderVariants&&) noexcept = default;
+    ShaderVariants& operator=(ShaderVariants&&) noexcept = default;
+
+    Shader& get(const shader::Defines& defines = {});
 
 private:
-    uint32_t m_ProgramID = 0;
+    std::string m_Vertex, m_VertexName, m_Fragment, m_FragmentName;
+    std::unordered_map<std::string, Shader> m_Variants;
 };
 
 } // namespace GRender
\ No newline at end of file
@@ -1,9 +1,138 @@
 #pragma once
 
+#include <array>
+#include <map>
+
 #include "core.h"
 
+namespace GRender::shader {
+
+// GLSL code kept in memory, e.g. embedded in the binary. Wrapping it into a type allows
+// constructors to tell it apart from a file path. Name is used for error messages and
+// relative #include directives are resolved from its parent directory.
+struct Source {
+    std::string_view code;
+    std::string_view name = "embedded source";
+};
+
+// Macros injected right after the #version directive, e.g. { {"TEXTURED", ""}, {"NUM_LIGHTS", "4"} }
+using Defines = std::map<std::string, std::string>;
+
+// Makes code available to '#include <name>' directives. "GRender/frame.glsl" is always available
+// and declares the frame uniform block.
+void RegisterInclude(const std::string& name, const std::string& code);
+
+// Expands #include directives and injects defines. Every file is included only once.
+// Shader constructors already call it, so it is mostly useful for debugging.
+std::string Preprocess(const Source& source, const Defines& defines = {});
+
+// Location of a uniform inside a linked program. Handles are cheap to copy and allow
+// hot loops to skip both the name lookup and the query to the driver.
+struct UniformHandle {
+    int32_t location = -1;
+
+    operator bool() const { return location >= 0; }
+};
+
+// Active resources of a linked program, as reported by the driver.
+// Size is the number of array elements, 1 for non-arrays.
+struct Variable {
+    std::string name;
+    GLenum type = GL_NONE;
+    int32_t size = 0;
+    int32_t location = -1;
+};
+
+struct StorageBlock {
+    std::string name;
+    int32_t binding = -1;
+    int32_t numBytes = 0; // size of the fixed part, unsized arrays count with zero elements
+};
+
+struct Reflection {
+    std::vector<Variable> uniforms;   // only the default block, no uniform block members
+    std::vector<Variable> attributes; // vertex inputs
+    std::vector<StorageBlock> storageBlocks;
+
+    const Variable* findUniform(const std::string& name) const;
+    const StorageBlock* findStorageBlock(const std::string& name) const;
+};
+
+// GLSL name of types reported in Reflection, e.g. "vec3" for GL_FLOAT_VEC3
+std::string_view TypeName(GLenum type);
+
+// How compute shaders use images and storage buffers. Written resources get a memory
+// barrier before anything reads them, so declaring read-only access avoids needless barriers.
+enum class Access { READ_ONLY, WRITE_ONLY, READ_WRITE };
+
+// Opt-in cache of linked program binaries. Next launches load programs from this directory
+// instead of compiling GLSL again, falling back to sources when the driver rejects a binary.
+// It requires a current OpenGL context.
+void EnableProgramCache(const fs::path& directory);
+void DisableProgramCache(void);
+
+// In asynchronous mode, programs created afterwards only submit compilation and linking to the
+// driver, so many programs can compile in parallel (GL_KHR_parallel_shader_compile) while the
+// application does other work. Errors are checked when each program is first used.
+void EnableAsyncCompilation(void);
+void DisableAsyncCompilation(void);
+
+} // namespace GRender::shader
+
 namespace GRender::shader::internal {
 
+using UniformMap = std::unordered_map<std::string, int32_t>;
+
+struct Stage {
+    GLenum type;
+    Source source;
+};
+
+// Linked program shared by Shader and ComputeShader. Compilation and linking go through the program
+// cache if enabled. In asynchronous mode, status checks and uniform queries are deferred until the
+// program is first used.
+class Program {
+public:
+    Program(const std::vector<Stage>& stages, const Defines& defines = {});
+    Program(void) = default;
+    ~Program(void);
+
+    Program(const Program&) = delete;
+    Program& operator=(const Program&) = delete;
+
+    Program(Program&&) noexcept;
+    Program& operator=(Program&&) noexcept;
+
+    // Blocks until the program is linked
+    uint32_t id(void) const;
+    // Checks without blocking if program can be used. Without GL_KHR_parallel_shader_compile status is
+    // unknown and it always returns true, first use then blocks until linking is done
+    bool isReady(void) const;
+
+    UniformHandle uniform(const std::string& name) const;
+    // Location of "texSampler[slot]" or -1
+    int32_t sampler(uint32_t slot) const;
+
+    // Queries the driver, so keep it out of hot loops
+    Reflection reflect(void) const;
+
+private:
+    void finalize(void) const;
+
+private:
+    uint32_t m_ProgramID = 0;
+
+    // Waiting for the driver in asynchronous mode. Shaders are stored with their descriptions
+    mutable bool m_Finalized = false;
+    mutable std::vector<std::pair<uint32_t, std::string>> m_Pending;
+    mutable std::string m_Names;
+    mutable uint64_t m_CacheKey = 0;
+
+    // Filled once the program is linked
+    mutable UniformMap m_Uniforms;
+    mutable std::vector<int32_t> m_Samplers;
+};
+
 static inline void CheckShaderError(uint32_t shader, uint32_t flag, bool isProgram, const std::string& msg) {
     int success = 0;
     if (isProgram) { glGetProgramiv(shader, flag, &success); }
@@ -18,34 +147,89 @@ static inline void CheckShaderError(uint32_t shader, uint32_t flag, bool isProgr
     }
 }
 
-static inline uint32_t CreateShader(const fs::path& shaderPath, GLenum shaderType) {
+static inline std::string ReadShaderFile(const fs::path& shaderPath) {
+    ASSERT(fs::exists(shaderPath), "Shader not found! => " + shaderPath.string());
+
     // Importing file into stream
     std::ifstream arq(shaderPath);
     std::stringstream strData;
     strData << arq.rdbuf();
     arq.close();
 
+    return strData.str();
+}
+
+// Submits compilation to the driver. Status is checked later on by the program
+static inline uint32_t CreateShader(const Source& source, GLenum shaderType) {
     // Creating shader from data
     uint32_t shader = glCreateShader(shaderType);
     ASSERT(shader != 0, "Failed to create shader!");
 
-    std::string data = strData.str();
-    GLint length = (GLint)data.size();
-    const GLchar* ptr = data.c_str();
+    GLint length = static_cast<GLint>(source.code.size());
+    const GLchar* ptr = source.code.data();
     glShaderSource(shader, 1, &ptr, &length);
     glCompileShader(shader);
 
-    std::string type;
+    return shader;
+}
+
+static inline std::string ShaderTypeName(GLenum shaderType) {
     switch (shaderType) {
-    case GL_VERTEX_SHADER:   type = "GL_VERTEX_SHADER"; break;
-    case GL_FRAGMENT_SHADER: type = "GL_FRAGMENT_SHADER"; break;
-    default:                 type = "GL_COMPUTE_SHADER"; break;
+    case GL_VERTEX_SHADER:   return "GL_VERTEX_SHADER";
+    case GL_FRAGMENT_SHADER: return "GL_FRAGMENT_SHADER";
+    default:                 return "GL_COMPUTE_SHADER";
+    }
+}
+
+// Introspects a linked program and stores the location of every active uniform.
+// Arrays are expanded, so each element can be found as "name[k]" and the first one also as "name"
+static inline UniformMap QueryUniformLocations(uint32_t programID) {
+    int32_t numUniforms = 0, maxLength = 0;
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &numUniforms);
+    glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    UniformMap map;
+    std::vector<char> buffer(static_cast<size_t>(maxLength) + 1);
+    for (int32_t k = 0; k < numUniforms; k++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(programID, k, maxLength, &length, &size, &type, buffer.data());
+
+        std::string name(buffer.data(), length);
+        int32_t loc = glGetUniformLocation(programID, name.c_str());
+        if (loc < 0) { continue; } // members of uniform blocks don't have a location
+
+        // Arrays are reported by its first element
+        const size_t pos = name.rfind("[0]");
+        if (pos == std::string::npos || pos + 3 != name.size()) {
+            map.emplace(name, loc);
+            continue;
+        }
+
+        name.erase(pos);
+        map.emplace(name, loc);
+        for (int32_t l = 0; l < size; l++) {
+            const std::string element = name + "[" + std::to_string(l) + "]";
+            map.emplace(element, glGetUniformLocation(programID, element.c_str()));
+        }
     }
 
-    std::string error = "Shader compilation failed :: " + type + " => " + shaderPath.string();
-    CheckShaderError(shader, GL_COMPILE_STATUS, false, error);
+    return map;
+}
 
-    return shader;
+// Locations of "texSampler[slot]", the sampler array used by Shader::setTexture, or of a single "texSampler"
+static inline std::vector<int32_t> QuerySamplerLocations(const UniformMap& uniforms) {
+    std::vector<int32_t> locations;
+    for (auto it = uniforms.find("texSampler[0]"); it != uniforms.end();
+         it = uniforms.find("texSampler[" + std::to_string(locations.size()) + "]")) {
+        locations.push_back(it->second);
+    }
+
+    // A single sampler works as slot 0
+    auto single = uniforms.find("texSampler");
+    if (locations.empty() && single != uniforms.end()) { locations.push_back(single->second); }
+    return locations;
 }
 
 
@@ -53,106 +237,192 @@ static inline uint32_t CreateShader(const fs::path& shaderPath, GLenum shaderTyp
 /////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename TP>
-inline void setUniform(uint32_t programID, const std::string& name, const TP& value) {
+inline void setUniform(int32_t loc, const TP& value) {
     ASSERT(false, "setUniform -> Unsupported type!");
 }
 
 
 // SINGLE VALUES //////////////////////////////////////////
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const int32_t& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const int32_t& val) {
     glUniform1i(loc, val);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const uint32_t& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const uint32_t& val) {
     glUniform1ui(loc, val);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const float& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const float& val) {
     glUniform1f(loc, val);
 }
 
 
 // VECTORS TWO ////////////////////////////////////////////
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::ivec2& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::ivec2& val) {
     glUniform2i(loc, val.x, val.y);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::uvec2& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::uvec2& val) {
     glUniform2ui(loc, val.x, val.y);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::vec2& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::vec2& val) {
     glUniform2f(loc, val.x, val.y);
 }
 
 
 // VECTORS THREE //////////////////////////////////////////
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::ivec3& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::ivec3& val) {
     glUniform3i(loc, val.x, val.y, val.z);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::uvec3& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::uvec3& val) {
     glUniform3ui(loc, val.x, val.y, val.z);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::vec3& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::vec3& val) {
     glUniform3f(loc, val.x, val.y, val.z);
 }
 
 // VECTORS FOUR ///////////////////////////////////////////
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::ivec4& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::ivec4& val) {
     glUniform4i(loc, val.x, val.y, val.z, val.w);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::uvec4& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::uvec4& val) {
     glUniform4ui(loc, val.x, val.y, val.z, val.w);
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::vec4& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::vec4& val) {
     glUniform4f(loc, val.x, val.y, val.z, val.w);
 }
 
 // MATRICES ///////////////////////////////////////////////
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::mat2& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::mat2& val) {
     glUniformMatrix2fv(loc, 1, false, glm::value_ptr(val));
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::mat3& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::mat3& val) {
     glUniformMatrix3fv(loc, 1, false, glm::value_ptr(val));
 }
 
 template<>
-inline void setUniform(uint32_t programID, const std::string& name, const glm::mat4& val) {
-    int32_t loc = glGetUniformLocation(programID, name.c_str());
+inline void setUniform(int32_t loc, const glm::mat4& val) {
     glUniformMatrix4fv(loc, 1, false, glm::value_ptr(val));
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Uploads count consecutive elements of an uniform array in a single call, starting at loc.
+// glm types are tightly packed, so they can be sent as plain arrays
+template <typename TP>
+inline void setUniformArray(int32_t loc, const TP* values, size_t count) {
+    ASSERT(false, "setUniform -> Unsupported array type!");
+}
+
+// SINGLE VALUES //////////////////////////////////////////
+template<>
+inline void setUniformArray(int32_t loc, const int32_t* values, size_t count) {
+    glUniform1iv(loc, static_cast<GLsizei>(count), values);
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const uint32_t* values, size_t count) {
+    glUniform1uiv(loc, static_cast<GLsizei>(count), values);
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const float* values, size_t count) {
+    glUniform1fv(loc, static_cast<GLsizei>(count), values);
+}
+
+// VECTORS TWO ////////////////////////////////////////////
+template<>
+inline void setUniformArray(int32_t loc, const glm::ivec2* values, size_t count) {
+    glUniform2iv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::uvec2* values, size_t count) {
+    glUniform2uiv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLuint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::vec2* values, size_t count) {
+    glUniform2fv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLfloat*>(values));
+}
+
+// VECTORS THREE //////////////////////////////////////////
+template<>
+inline void setUniformArray(int32_t loc, const glm::ivec3* values, size_t count) {
+    glUniform3iv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::uvec3* values, size_t count) {
+    glUniform3uiv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLuint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::vec3* values, size_t count) {
+    glUniform3fv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLfloat*>(values));
+}
+
+// VECTORS FOUR ///////////////////////////////////////////
+template<>
+inline void setUniformArray(int32_t loc, const glm::ivec4* values, size_t count) {
+    glUniform4iv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::uvec4* values, size_t count) {
+    glUniform4uiv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLuint*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::vec4* values, size_t count) {
+    glUniform4fv(loc, static_cast<GLsizei>(count), reinterpret_cast<const GLfloat*>(values));
+}
+
+// MATRICES ///////////////////////////////////////////////
+template<>
+inline void setUniformArray(int32_t loc, const glm::mat2* values, size_t count) {
+    glUniformMatrix2fv(loc, static_cast<GLsizei>(count), false, reinterpret_cast<const GLfloat*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::mat3* values, size_t count) {
+    glUniformMatrix3fv(loc, static_cast<GLsizei>(count), false, reinterpret_cast<const GLfloat*>(values));
+}
+
+template<>
+inline void setUniformArray(int32_t loc, const glm::mat4* values, size_t count) {
+    glUniformMatrix4fv(loc, static_cast<GLsizei>(count), false, reinterpret_cast<const GLfloat*>(values));
+}
+
+// CONTAINERS /////////////////////////////////////////////
+template <typename TP>
+inline void setUniform(int32_t loc, const std::vector<TP>& values) {
+    setUniformArray<TP>(loc, values.data(), values.size());
+}
+
+template <typename TP, size_t N>
+inline void setUniform(int32_t loc, const std::array<TP, N>& values) {
+    setUniformArray<TP>(loc, values.data(), N);
+}
+
 } // namespace GRender::shader::internal
@@ -1,13 +1,25 @@
 #pragma once
 
+#include <memory>
+
 #include "core.h"
+#include "glState.h"
+#include "readback.h"
 
 namespace GRender {
 
 class  StorageBuffer {
+public:
+    struct UpdateStatistics {
+        uint64_t updates = 0;       // calls to update
+        uint64_t uploads = 0;       // transfers sent to the driver, updates - uploads were saved
+        uint64_t bytesUploaded = 0;
+        uint64_t fullUploads = 0;   // flushes that orphaned and uploaded the whole buffer
+    };
+
 public:
     StorageBuffer(size_t numBytes, const void* data = nullptr);
-    StorageBuffer(void) = default;
+    StorageBuffer(void);
     ~StorageBuffer(void);
 
     // We should not copy GPU data
@@ -19,10 +31,31 @@ public:
     
     uint32_t id(void) const { return m_BufferID; }
     size_t numBytes(void) const { return m_NumBytes; }
+    size_t capacity(void) const { return m_Capacity; }
+
+    // Grows allocation to at least numBytes, copying current contents on the GPU. Id changes
+    void reserve(size_t numBytes);
+    // Changes size, growing capacity geometrically. Contents up to the smallest size are kept
+    void resize(size_t numBytes);
 
     void bind(uint32_t location = 0) const;
     void update(const void* data, size_t offset = 0, size_t numBytes = 0);
 
+    // In deferred mode, update only writes into a CPU copy and records dirty ranges. Overlapping
+    // and close ranges are merged and uploaded at once by flush, which also runs before the buffer
+    // is bound or read. Meant for CPU owned data, as flushes overwrite what shaders wrote
+    void setDeferred(bool deferred);
+    bool isDeferred(void) const { return m_Deferred != nullptr; }
+    // Uploads dirty ranges, or orphans and uploads everything if most of the buffer changed
+    void flush(void) const;
+
+    const UpdateStatistics& updateStatistics(void) const { return m_Stats; }
+    void resetUpdateStatistics(void) { m_Stats = {}; }
+
+    // Queues a copy of numBytes (default all) starting at offset, without waiting for the GPU
+    Readback readAsync(size_t offset = 0, size_t numBytes = 0) const;
+
+    // Waits for the GPU to finish everything queued, prefer readAsync in hot paths
     template <typename TP>
     std::vector<TP> getBuffer(size_t offset = 0ul, size_t numElements = 0ul) const {
         // Default size return all the available data 
@@ -31,15 +64,59 @@ public:
         }
 
         std::vector<TP> vec(numElements);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BufferID);
-        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, numElements * sizeof(TP), vec.data());
+        flush();
+        gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glGetNamedBufferSubData(m_BufferID, offset, numElements * sizeof(TP), vec.data());
         return vec;
     }
 
     operator bool() const { return m_BufferID > 0; }
 private:
+    struct Deferred;
+
     uint32_t m_BufferID = 0;
-    size_t m_NumBytes = 0;
+    size_t m_NumBytes = 0, m_Capacity = 0;
+
+    std::unique_ptr<Deferred> m_Deferred;
+    mutable UpdateStatistics m_Stats;
+};
+
+// Storage for kernels producing a variable number of elements. Each producer takes its index from
+// an atomic counter and drops elements beyond capacity, so the counter tells how many were meant:
+//     layout(std430, binding = 0) writeonly buffer Items { Particle items[]; };
+//     layout(std430, binding = 1) buffer Counter { uint count; };
+//     uint id = atomicAdd(count, 1);
+//     if (id < items.length()) { items[id] = particle; }
+// Bind both with ComputeShader::setBuffer. Counter works with compute::WriteDispatchArgs for consumers
+class AppendBuffer {
+public:
+    AppendBuffer(size_t elementBytes, size_t capacity);
+    AppendBuffer(void) = default;
+
+    const StorageBuffer& data(void) const { return m_Data; }
+    const StorageBuffer& counter(void) const { return m_Counter; }
+
+    size_t elementBytes(void) const { return m_ElementBytes; }
+    size_t capacity(void) const { return m_Data.numBytes() / m_ElementBytes; }
+
+    // Sets counter to zero before a new producer pass
+    void reset(void);
+    // Grows storage keeping appended elements, all on the GPU
+    void reserve(size_t capacity);
+
+    // Elements producers tried to append, can be larger than capacity. Waits for the GPU
+    uint32_t count(void) const;
+    // Same as above without waiting, result is a single uint
+    Readback countAsync(void) const { return m_Counter.readAsync(); }
+
+    // Reads counter and, if producers overflowed, grows to fit them. Returns false if the pass must run again
+    bool fit(void);
+
+    operator bool() const { return m_Data && m_Counter; }
+
+private:
+    StorageBuffer m_Data, m_Counter;
+    size_t m_ElementBytes = 1;
 };
 
 } // namespace GRender
\ No newline at end of file
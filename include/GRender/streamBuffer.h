@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core.h"
+
+namespace GRender {
+
+// Buffer for data rewritten every frame, e.g. simulation state. Storage is mapped once, persistent
+// and coherent, and split into regions used round robin. While the GPU reads one region the CPU
+// writes the next, so uploads need no copies and only wait if the GPU falls behind by more than
+// numRegions - 1 frames.
+//
+// Usage, once per frame:
+//     Particle* ptr = stream.next<Particle>();   // fences previous region and waits for this one
+//     ... write up to stream.capacity<Particle>() elements ...
+//     stream.bind(0);                            // binds current region as a range
+//     shader.dispatch(...);
+class StreamBuffer {
+public:
+    StreamBuffer(size_t regionBytes, uint32_t numRegions = 3);
+    StreamBuffer(void) = default;
+    ~StreamBuffer(void);
+
+    // We should not copy GPU data
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+    // But we can move IDs around
+    StreamBuffer(StreamBuffer&&) noexcept;
+    StreamBuffer& operator=(StreamBuffer&&) noexcept;
+
+    uint32_t id(void) const { return m_BufferID; }
+    size_t regionBytes(void) const { return m_RegionBytes; }
+    uint32_t numRegions(void) const { return static_cast<uint32_t>(m_Fences.size()); }
+    // Offset in bytes of current region, for bindings done by hand
+    size_t offset(void) const { return m_Current * m_Stride; }
+    // Number of times next() had to wait for the GPU
+    uint64_t stalls(void) const { return m_Stalls; }
+
+    // Moves to the next region. Commands queued so far are the last allowed to read the previous one
+    void* next(void);
+    template <typename TP>
+    TP* next(void) { return static_cast<TP*>(next()); }
+
+    // Writable memory of the current region
+    void* data(void) const { return static_cast<uint8_t*>(m_Mapped) + offset(); }
+    template <typename TP>
+    TP* data(void) const { return static_cast<TP*>(data()); }
+    template <typename TP>
+    size_t capacity(void) const { return m_RegionBytes / sizeof(TP); }
+
+    // Binds current region to indexed target, e.g. GL_UNIFORM_BUFFER
+    void bind(uint32_t location = 0, GLenum target = GL_SHADER_STORAGE_BUFFER) const;
+
+    operator bool() const { return m_BufferID > 0; }
+
+private:
+    uint32_t m_BufferID = 0;
+    void* m_Mapped = nullptr;
+    size_t m_RegionBytes = 0, m_Stride = 0;
+
+    std::vector<GLsync> m_Fences;
+    uint32_t m_Current = 0;
+    uint64_t m_Stalls = 0;
+};
+
+} // namespace GRender
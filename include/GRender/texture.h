@@ -1,6 +1,8 @@
 #pragma once
 
 #include "core.h"
+#include "readback.h"
+#include "streamBuffer.h"
 
 namespace GRender {
 
@@ -11,7 +13,13 @@ enum class Format : uint8_t {
     RGBA32,
     INTEGER,
     UNSIGNED_INTEGER,
-    FLOAT
+    FLOAT,
+
+    // Block compressed RGBA, 4x4 texels per block. Upload levels with Texture::updateLevel or
+    // build them from files with utils::createCompressedTextureFromFile
+    BC1, // 8 bytes per block, opaque color
+    BC3, // 16 bytes per block, color and smooth alpha
+    BC7  // 16 bytes per block, best quality
 };
 
 enum class Filter : uint8_t {
@@ -31,13 +39,29 @@ struct Specification {
     struct {
         Filter min = Filter::LINEAR;
         Filter mag = Filter::NEAREST;
+        Filter mipmap = Filter::LINEAR; // between levels, linear min and mipmap is trilinear
     } filter;
 
     struct {
         Wrap x = Wrap::BORDER;
         Wrap y = Wrap::BORDER;
     } wrap;
+
+    // Number of mipmap levels, zero allocates the full chain down to 1x1
+    uint32_t levels = 1;
+    // Mipmaps are rebuilt after every update, otherwise call Texture::generateMipmaps
+    bool autoMipmaps = true;
+    // Number of samples taken along the direction of anisotropy, one disables it.
+    // Clamped to hardware limit
+    float anisotropy = 1.0f;
 };
+
+bool operator==(const Specification& a, const Specification& b);
+inline bool operator!=(const Specification& a, const Specification& b) { return !(a == b); }
+
+inline bool IsCompressed(Format fmt) { return fmt == Format::BC1 || fmt == Format::BC3 || fmt == Format::BC7; }
+// Bytes taken by a single level of given size, whole blocks for compressed formats
+size_t NumBytes(Format fmt, const glm::uvec2& size);
 } // namespace texture
 
 class  Texture {
@@ -57,19 +81,119 @@ public:
     uint32_t id(void) const { return m_TexID;  }
     glm::uvec2 size(void) const { return m_Size; }
     Specification specification(void) const { return m_Spec;  }
-
+    // Allocated mipmap levels
+    uint32_t levels(void) const { return m_Levels; }
+    // Video memory used by all levels
+    size_t numBytes(void) const;
 
     void bind(uint32_t slot = 0) const;
     void update(const void* data);
+    // Uploads a single level, without rebuilding the others. Compressed data is given in blocks
+    void updateLevel(uint32_t level, const void* data);
     void resize(const glm::uvec2& size);
 
+    // Rebuilds all levels from the first one. RGBA8 uses glGenerateMipmap, other formats use
+    // a compute shader averaging 2x2 blocks, or taking the first texel for integer formats.
+    // Compressed formats can't be rebuilt, so their levels must be uploaded one by one
+    void generateMipmaps(void);
+
+    // Queues a copy of all pixels, rows from bottom to top, without waiting for the GPU.
+    // Compressed textures return their blocks
+    Readback readAsync(void) const;
+
     operator bool() const { return m_TexID > 0; }
 private:
     uint32_t m_TexID = 0;
     glm::uvec2 m_Size = { 0, 0 };
+    uint32_t m_Levels = 1;
     Specification m_Spec;
 };
 
+// Stack of same size textures sampled as sampler2DArray, so many images can be used by a single draw
+// call with a layer index. Mipmaps can only be generated for RGBA8, other formats get one level.
+// With autoMipmaps, updates only mark levels as outdated and they are generated once on next bind.
+class TextureArray {
+    using Specification = texture::Specification;
+public:
+    TextureArray(const glm::uvec2& size, uint32_t numLayers, const texture::Specification& spec = texture::Specification());
+    TextureArray(void) = default;
+    ~TextureArray(void);
+
+    // We should not copy GPU data
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+    // But we can move IDs around
+    TextureArray(TextureArray&&) noexcept;
+    TextureArray& operator=(TextureArray&&) noexcept;
+
+    uint32_t id(void) const { return m_TexID; }
+    glm::uvec2 size(void) const { return m_Size; }
+    uint32_t numLayers(void) const { return m_NumLayers; }
+    uint32_t levels(void) const { return m_Levels; }
+    Specification specification(void) const { return m_Spec; }
+
+    void bind(uint32_t slot = 0) const;
+    void update(uint32_t layer, const void* data);
+    // Copies all pixels of texture into layer on the GPU. Size and format must match
+    void copy(uint32_t layer, const Texture& texture);
+    void generateMipmaps(void);
+
+    operator bool() const { return m_TexID > 0; }
+private:
+    void buildMipmaps(void) const;
+
+private:
+    uint32_t m_TexID = 0;
+    glm::uvec2 m_Size = { 0, 0 };
+    uint32_t m_NumLayers = 0, m_Levels = 1;
+    Specification m_Spec;
+    mutable bool m_MipsDirty = false;
+};
+
+// Streams frames into textures every frame, e.g. camera or video. Frames are written into the
+// regions of a StreamBuffer used as pixel buffer, so uploads happen asynchronously on the GPU, and
+// writing only waits if the GPU is more than numBuffers - 1 frames behind. Acquire and submit must
+// run on the OpenGL thread, but acquired memory can be filled from any thread before being submitted.
+//
+// Usage:
+//     void* frame = stream.acquire();
+//     decoder.decodeInto(frame);          // frameBytes() bytes, rows from bottom to top
+//     stream.submit(texture);
+class TextureStream {
+public:
+    TextureStream(const glm::uvec2& size, texture::Format fmt, uint32_t numBuffers = 3);
+    TextureStream(void) = default;
+    ~TextureStream(void) = default;
+
+    // We should not copy GPU data
+    TextureStream(const TextureStream&) = delete;
+    TextureStream& operator=(const TextureStream&) = delete;
+    // But we can move IDs around
+    TextureStream(TextureStream&&) noexcept;
+    TextureStream& operator=(TextureStream&&) noexcept;
+
+    glm::uvec2 size(void) const { return m_Size; }
+    texture::Format format(void) const { return m_Format; }
+    size_t frameBytes(void) const { return m_FrameBytes; }
+    uint32_t numBuffers(void) const { return m_Buffer.numRegions(); }
+    // Number of times acquire had to wait for the GPU
+    uint64_t stalls(void) const { return m_Buffer.stalls(); }
+
+    // Memory for the next frame. Each acquired frame must be submitted before acquiring another
+    void* acquire(void);
+    // Uploads acquired frame into texture, which must have same size and format
+    void submit(Texture& texture);
+
+    operator bool() const { return bool(m_Buffer); }
+
+private:
+    StreamBuffer m_Buffer;
+    glm::uvec2 m_Size = { 0, 0 };
+    texture::Format m_Format = texture::Format::NONE;
+    size_t m_FrameBytes = 0;
+    bool m_Acquired = false;
+};
+
 // this namespace should be centralized somewhere else at some point
 namespace utils {
 Texture createTextureFromRGBAFile(const fs::path& filepath, texture::Specification spec = texture::Specification());
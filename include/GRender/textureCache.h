@@ -0,0 +1,83 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "core.h"
+
+#include "texture.h"
+
+namespace GRender {
+
+class TextureLoader;
+
+// Shares textures loaded from files, keyed by canonical path and specification, so the same image
+// is decoded and uploaded only once. When video memory used by cached textures goes over budget,
+// least recently requested ones are dropped. Textures still held outside the cache are never
+// dropped, since that would not free anything. Dropped files are loaded again on their next get.
+//
+// Usage, e.g. an image browser:
+//     std::shared_ptr<Texture> thumb = cache.get(path); // every frame the image is visible
+class TextureCache {
+public:
+    struct Statistics {
+        size_t hits = 0, misses = 0, evictions = 0;
+    };
+
+public:
+    // Files are loaded through loader, if given, otherwise synchronously
+    TextureCache(size_t budgetBytes = 512ull << 20, TextureLoader* loader = nullptr);
+    ~TextureCache(void) = default;
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    TextureCache(TextureCache&&) noexcept = default;
+    TextureCache& operator=(TextureCache&&) noexcept = default;
+
+    // Files that fail to load are not kept, so next get tries again. Synchronous loads return an
+    // empty texture, loader ones keep the placeholder and are dropped once the loader gives up
+    std::shared_ptr<Texture> get(const fs::path& filepath, const texture::Specification& spec = texture::Specification());
+
+    // Drops unused entries until usage fits the budget. Runs after every miss, but handles released
+    // in between are only noticed here
+    void trim(void);
+    // Drops every unused entry and forgets resolved paths, e.g. after symlinks changed
+    void clear(void);
+
+    void setBudget(size_t budgetBytes);
+    size_t budget(void) const { return m_Budget; }
+    // Video memory used by cached textures
+    size_t usage(void) const { return m_Usage; }
+    size_t size(void) const { return m_Entries.size(); }
+
+    const Statistics& statistics(void) const { return m_Stats; }
+
+private:
+    struct Entry {
+        std::string key;
+        texture::Specification spec;
+        std::shared_ptr<Texture> texture;
+        size_t numBytes;
+    };
+
+    using Iterator = std::list<Entry>::iterator;
+
+    const std::string& canonicalKey(const fs::path& filepath);
+    void evict(size_t budget);
+    void erase(Iterator it);
+    void dropFailed(void);
+
+private:
+    std::list<Entry> m_Entries; // most recently requested first
+    std::unordered_multimap<std::string, Iterator> m_Lookup;
+    std::unordered_map<fs::path::string_type, std::string> m_Canonical; // path as given -> key
+
+    // Filled by loader callbacks, shared so they never refer to a moved or destroyed cache
+    std::shared_ptr<std::vector<std::weak_ptr<Texture>>> m_Failed = std::make_shared<std::vector<std::weak_ptr<Texture>>>();
+
+    TextureLoader* m_Loader = nullptr;
+    size_t m_Budget = 0, m_Usage = 0;
+    Statistics m_Stats;
+};
+
+} // namespace GRender
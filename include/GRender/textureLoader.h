@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "core.h"
+
+#include "texture.h"
+#include "streamBuffer.h"
+
+namespace GRender {
+
+class Progress;
+
+// Loads RGBA8 images without freezing the render thread. Worker threads decode files with
+// stb_image and update() uploads decoded pixels through a pixel buffer, a few rows at a time so
+// no frame uploads more than the budget. Textures are returned right away, sized from the file
+// header and cleared to a placeholder color until their pixels arrive.
+//
+// Usage:
+//     std::shared_ptr<Texture> photo = loader.load("photo.jpg");
+//     ...
+//     loader.update(); // once per frame, on the OpenGL thread
+class TextureLoader {
+public:
+    // Runs on the OpenGL thread during update, once pixels are uploaded or loading failed
+    using Callback = std::function<void(const fs::path& path, bool success)>;
+
+public:
+    TextureLoader(uint32_t numThreads = 2, size_t uploadBudget = 32ull << 20);
+    ~TextureLoader(void);
+
+    // Workers keep a pointer to the loader
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+    TextureLoader(TextureLoader&&) = delete;
+    TextureLoader& operator=(TextureLoader&&) = delete;
+
+    // Queues file for decoding. Dropping the texture before it is loaded skips remaining work
+    std::shared_ptr<Texture> load(const fs::path& filepath, const texture::Specification& spec = texture::Specification(),
+                                  const Callback& callback = nullptr);
+
+    // Uploads decoded images within the budget and runs callbacks. Call it once per frame
+    void update(void);
+    // Drops queued files. Their callbacks report failure and textures keep the placeholder
+    void cancel(void);
+
+    // Files not fully uploaded yet
+    size_t numPending(void) const;
+
+    void setPlaceholder(const glm::vec4& color) { m_Placeholder = color; }
+    // Displays a progress bar in the mailbox while files are loading
+    void setShowProgress(bool show) { m_ShowProgress = show; }
+
+private:
+    struct Job {
+        fs::path path;
+        std::weak_ptr<Texture> texture;
+        Callback callback;
+        glm::uvec2 size = { 0, 0 };
+        std::unique_ptr<uint8_t, void (*)(void*)> pixels{ nullptr, nullptr };
+        uint32_t nextRow = 0;
+        bool failed = false;
+    };
+
+    void work(void);
+    void finish(Job& job, bool success);
+
+private:
+    std::vector<std::thread> m_Workers;
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<std::unique_ptr<Job>> m_Queue, m_Decoded; // guarded by mutex
+    bool m_Quit = false;
+
+    // Only touched by the OpenGL thread
+    std::deque<std::unique_ptr<Job>> m_Uploading;
+    StreamBuffer m_Staging;
+    size_t m_Budget = 0;
+    glm::vec4 m_Placeholder = { 0.5f, 0.5f, 0.5f, 1.0f };
+
+    bool m_ShowProgress = false;
+    Progress* m_Progress = nullptr;
+    size_t m_Total = 0, m_Done = 0;
+};
+
+} // namespace GRender
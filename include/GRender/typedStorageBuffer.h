@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include "core.h"
+
+#include "storageBuffer.h"
+
+namespace GRender {
+
+// Non-owning view over contiguous elements, similar to std::span
+template <typename TP>
+class ArrayView {
+public:
+    ArrayView(void) = default;
+    ArrayView(TP* data, size_t size) : m_Data(data), m_Size(size) {}
+    ArrayView(TP& element) : m_Data(&element), m_Size(1) {}
+
+    template <typename VP, typename = std::enable_if_t<std::is_convertible_v<VP(*)[], TP(*)[]>>>
+    ArrayView(std::vector<VP>& vec) : m_Data(vec.data()), m_Size(vec.size()) {}
+    template <typename VP, typename = std::enable_if_t<std::is_convertible_v<const VP(*)[], TP(*)[]>>>
+    ArrayView(const std::vector<VP>& vec) : m_Data(vec.data()), m_Size(vec.size()) {}
+    template <typename VP, size_t N, typename = std::enable_if_t<std::is_convertible_v<VP(*)[], TP(*)[]>>>
+    ArrayView(std::array<VP, N>& arr) : m_Data(arr.data()), m_Size(N) {}
+    template <typename VP, size_t N, typename = std::enable_if_t<std::is_convertible_v<const VP(*)[], TP(*)[]>>>
+    ArrayView(const std::array<VP, N>& arr) : m_Data(arr.data()), m_Size(N) {}
+
+    TP* data(void) const { return m_Data; }
+    size_t size(void) const { return m_Size; }
+    bool empty(void) const { return m_Size == 0; }
+
+    TP* begin(void) const { return m_Data; }
+    TP* end(void) const { return m_Data + m_Size; }
+    TP& operator[](size_t id) const { return m_Data[id]; }
+
+    ArrayView subview(size_t first, size_t count) const { return { m_Data + first, count }; }
+
+private:
+    TP* m_Data = nullptr;
+    size_t m_Size = 0;
+};
+
+// Helpers to declare structs matching GLSL std430 layout. Scalars, vec2, vec4 and mat4 from glm
+// already match. vec3 is aligned to 16 bytes in GLSL but only 4 in glm, so either follow a
+// glm::vec3 by a 4 bytes scalar or use std430::vec3, which carries its own padding:
+//     struct Particle {                        // GLSL: struct Particle {
+//         glm::vec3 position; float mass;      //     vec3 position; float mass;
+//         std430::vec3 velocity;               //     vec3 velocity;
+//         glm::vec4 color;                     //     vec4 color; };
+//     };
+//     STD430_OFFSET(Particle, velocity, 16);
+//     STD430_OFFSET(Particle, color, 32);
+//     STD430_SIZE(Particle, 48);
+namespace std430 {
+
+struct alignas(16) vec3 : glm::vec3 {
+    using glm::vec3::vec3;
+    vec3(void) : glm::vec3(0.0f) {}
+    vec3(const glm::vec3& vec) : glm::vec3(vec) {}
+};
+static_assert(sizeof(vec3) == 16 && alignof(vec3) == 16);
+
+// Requirements for elements uploaded without repacking. Members can't be inspected, so this doesn't
+// validate struct layouts, e.g. a glm::vec3 not followed by a scalar goes unnoticed. Only
+// STD430_OFFSET and STD430_SIZE next to the struct declaration catch those
+template <typename TP>
+constexpr bool IsValidElement(void) {
+    return std::is_trivially_copyable_v<TP> && std::is_standard_layout_v<TP> && alignof(TP) <= 16 && sizeof(TP) % 4 == 0;
+}
+
+// vec3 arrays have 16 bytes stride in std430 but 12 bytes in C++
+template <typename TP>
+constexpr bool IsPackedVec3(void) {
+    return std::is_same_v<TP, glm::vec3> || std::is_same_v<TP, glm::ivec3> || std::is_same_v<TP, glm::uvec3>;
+}
+
+} // namespace std430
+
+// Compares offset of a member against the value following GLSL std430 rules
+#define STD430_OFFSET(TYPE, MEMBER, OFFSET) \
+    static_assert(offsetof(TYPE, MEMBER) == (OFFSET), #TYPE "::" #MEMBER " doesn't follow std430 layout")
+
+// Compares size of a struct against its std430 array stride, i.e. size rounded up to the largest
+// member alignment
+#define STD430_SIZE(TYPE, SIZE) \
+    static_assert(sizeof(TYPE) == (SIZE), #TYPE " size doesn't follow std430 layout")
+
+// Storage buffer holding elements of type TP. Sizes and offsets are given in elements and
+// layout requirements are checked at compile time
+template <typename TP>
+class TypedStorageBuffer : public StorageBuffer {
+    static_assert(std430::IsValidElement<TP>(), "Elements must be trivially copyable, standard layout, with size multiple of 4 and alignment up to 16");
+    static_assert(!std430::IsPackedVec3<TP>(), "vec3 arrays have 16 bytes stride in std430, use std430::vec3 or glm::vec4");
+
+public:
+    TypedStorageBuffer(void) = default;
+    explicit TypedStorageBuffer(size_t count) : StorageBuffer(count * sizeof(TP)) {}
+    TypedStorageBuffer(ArrayView<const TP> elements) : StorageBuffer(elements.size() * sizeof(TP), elements.data()) {}
+
+    size_t size(void) const { return numBytes() / sizeof(TP); }
+
+    void update(ArrayView<const TP> elements, size_t first = 0) {
+        ASSERT(first + elements.size() <= size(), "Update is out of buffer bounds!!");
+        if (elements.empty()) { return; }
+        StorageBuffer::update(elements.data(), first * sizeof(TP), elements.size() * sizeof(TP));
+    }
+
+    // Count zero means up to the end. read waits for the GPU, readAsync does not
+    std::vector<TP> read(size_t first = 0, size_t count = 0) const {
+        count = checkRange(first, count);
+        return count == 0 ? std::vector<TP>() : getBuffer<TP>(first * sizeof(TP), count);
+    }
+    Readback readAsync(size_t first = 0, size_t count = 0) const {
+        count = checkRange(first, count);
+        return StorageBuffer::readAsync(first * sizeof(TP), count * sizeof(TP));
+    }
+
+private:
+    size_t checkRange(size_t first, size_t count) const {
+        ASSERT(first <= size(), "Range is out of buffer bounds!!");
+        if (count == 0) { count = size() - first; }
+        ASSERT(first + count <= size(), "Range is out of buffer bounds!!");
+        return count;
+    }
+};
+
+} // namespace GRender
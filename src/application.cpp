@@ -1,9 +1,12 @@
 #include "application.h"
+#include "frame.h"
+#include "glState.h"
 
 namespace GRender {
 
 void winResize_callback(GLFWwindow*, int width, int height) {
-    glad_glViewport(0, 0, width, height);
+    gl::Viewport(0, 0, width, height);
+    frame::SetViewport({ static_cast<uint32_t>(width), static_cast<uint32_t>(height) });
 }
 
 /*****************************************************************************/
@@ -54,7 +57,8 @@ Application::Application(const std::string& name, uint32_t width, uint32_t heigh
 #endif
 
     // Setup viewport -> opengl is going transform final coordinates into this range
-    glad_glViewport(0, 0, static_cast<int>(width), static_cast<int>(height));
+    gl::Viewport(0, 0, static_cast<int>(width), static_cast<int>(height));
+    frame::SetViewport({ width, height });
 
     ///////////////////////////////////////////////////////////////////////////
     // HANDLING WINDOW PROPERTIES
@@ -131,7 +135,11 @@ void Application::run(void) {
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        // Bind statistics are shown per frame
+        gl::ResetStatistics();
+
         // Updating application
+        frame::SetTime(static_cast<float>(t0), m_DeltaTime);
         onUserUpdate(m_DeltaTime);
 
         ImGuiWindowFlags window_flags = ImGuiWindowFlags_None;
@@ -180,6 +188,7 @@ void Application::run(void) {
 
         // Render ImGui // It calls endFrame automatically
         ImGui::Render();
+        gl::FlushBarriers(GL_TEXTURE_FETCH_BARRIER_BIT); // widgets may sample textures written by compute shaders
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
         // Allows rendering of external floating windows
@@ -188,6 +197,9 @@ void Application::run(void) {
         ImGui::RenderPlatformWindowsDefault();
         glfwMakeContextCurrent(backup_current_context);
 
+        // ImGui changed bindings behind our back
+        gl::Invalidate();
+
         ///////////////////////////////////////////////////
 
         // Swap secondary buffer to screen
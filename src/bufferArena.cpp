@@ -0,0 +1,143 @@
+#include "bufferArena.h"
+
+namespace GRender {
+
+BufferSlice::~BufferSlice(void) {
+    if (m_Arena) { m_Arena->release(m_Offset, m_BlockBytes); }
+}
+
+BufferSlice::BufferSlice(BufferSlice&& slice) noexcept {
+    std::swap(m_Arena, slice.m_Arena);
+    std::swap(m_Offset, slice.m_Offset);
+    std::swap(m_NumBytes, slice.m_NumBytes);
+    std::swap(m_BlockBytes, slice.m_BlockBytes);
+}
+
+BufferSlice& BufferSlice::operator=(BufferSlice&& slice) noexcept {
+    if (this != &slice) {
+        this->~BufferSlice();
+        new(this) BufferSlice(std::move(slice));
+    }
+    return *this;
+}
+
+uint32_t BufferSlice::id(void) const {
+    return m_Arena ? m_Arena->id() : 0;
+}
+
+void BufferSlice::bind(uint32_t location, GLenum target) const {
+    ASSERT(*this, "BufferSlice not initialized!!");
+    gl::Consume(gl::Resource::BUFFER, id(), GL_SHADER_STORAGE_BARRIER_BIT);
+    gl::BindBufferRange(target, location, id(), m_Offset, m_NumBytes);
+}
+
+void BufferSlice::update(const void* data, size_t offset, size_t numBytes) {
+    ASSERT(*this, "BufferSlice not initialized!!");
+    if (numBytes == 0) { numBytes = m_NumBytes - offset; }
+    ASSERT(offset + numBytes <= m_NumBytes, "Update is out of slice bounds!!");
+
+    gl::Consume(gl::Resource::BUFFER, id(), GL_BUFFER_UPDATE_BARRIER_BIT);
+    glNamedBufferSubData(id(), m_Offset + offset, numBytes, data);
+}
+
+Readback BufferSlice::readAsync(size_t offset, size_t numBytes) const {
+    ASSERT(*this, "BufferSlice not initialized!!");
+    if (numBytes == 0) { numBytes = m_NumBytes - offset; }
+    ASSERT(offset + numBytes <= m_NumBytes, "Readback range is out of slice bounds!!");
+
+    Readback readback(numBytes);
+    gl::Consume(gl::Resource::BUFFER, id(), GL_BUFFER_UPDATE_BARRIER_BIT);
+    glCopyNamedBufferSubData(id(), readback.m_BufferID, m_Offset + offset, 0, numBytes);
+    readback.fence();
+    return readback;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+BufferArena::BufferArena(size_t capacity) : m_Capacity(capacity) {
+    ASSERT(capacity > 0, "BufferArena cannot be empty!!");
+
+    GLint ssboAlign = 0, uboAlign = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssboAlign);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+    m_Alignment = std::max<size_t>({ 4, size_t(ssboAlign), size_t(uboAlign) });
+
+    // Immutable storage, slices are still updated with glNamedBufferSubData
+    glCreateBuffers(1, &m_BufferID);
+    glNamedBufferStorage(m_BufferID, m_Capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    m_Free[0] = m_Capacity;
+    m_Stats.capacity = m_Capacity;
+    m_Stats.largestFree = m_Capacity;
+    m_Stats.numFreeBlocks = 1;
+}
+
+BufferArena::~BufferArena(void) {
+    ASSERT(m_Stats.numSlices == 0, "BufferArena destroyed while slices are still alive!!");
+    gl::DeleteBuffer(m_BufferID);
+}
+
+BufferSlice BufferArena::allocate(size_t numBytes, const void* data) {
+    ASSERT(numBytes > 0, "Cannot allocate empty slice!!");
+
+    // Every block starts aligned, so rounding sizes keeps it that way
+    const size_t blockBytes = (numBytes + m_Alignment - 1) / m_Alignment * m_Alignment;
+
+    auto best = m_Free.end();
+    for (auto it = m_Free.begin(); it != m_Free.end(); it++) {
+        if (it->second >= blockBytes && (best == m_Free.end() || it->second < best->second)) {
+            best = it;
+            if (it->second == blockBytes) { break; }
+        }
+    }
+
+    if (best == m_Free.end()) {
+        WARN("BufferArena has no free block of " + std::to_string(numBytes) + " bytes");
+        return {};
+    }
+
+    const size_t offset = best->first, blockSize = best->second;
+    m_Free.erase(best);
+    if (blockSize > blockBytes) { m_Free[offset + blockBytes] = blockSize - blockBytes; }
+
+    m_Stats.used += blockBytes;
+    m_Stats.numSlices++;
+    m_Stats.numFreeBlocks = m_Free.size();
+    if (blockSize == m_Stats.largestFree) {
+        m_Stats.largestFree = 0;
+        for (auto& [off, size] : m_Free) { m_Stats.largestFree = std::max(m_Stats.largestFree, size); }
+    }
+
+    BufferSlice slice(this, offset, numBytes, blockBytes);
+    if (data) { slice.update(data); }
+    return slice;
+}
+
+void BufferArena::release(size_t offset, size_t numBytes) {
+    auto [it, inserted] = m_Free.emplace(offset, numBytes);
+    ASSERT(inserted, "BufferSlice released twice!!");
+
+    // Merging with next block
+    auto next = std::next(it);
+    if (next != m_Free.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        m_Free.erase(next);
+    }
+
+    // Merging with previous block
+    if (it != m_Free.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            m_Free.erase(it);
+            it = prev;
+        }
+    }
+
+    m_Stats.used -= numBytes;
+    m_Stats.numSlices--;
+    m_Stats.numFreeBlocks = m_Free.size();
+    m_Stats.largestFree = std::max(m_Stats.largestFree, it->second);
+}
+
+} // namespace GRender
@@ -4,6 +4,7 @@
 
 #include "events.h"
 #include "fonts.h"
+#include "frame.h"
 #include "utils.h"
 
 namespace GRender {
@@ -97,9 +98,23 @@ void Camera::display(void) {
 }
 
 glm::mat4 Camera::getViewMatrix(void) {
-    glm::mat4 proj = glm::perspective(m_FOV, m_Ratio, m_Near, m_Far);
-    glm::mat4 view = glm::lookAt(m_Position, m_Position + m_Front, {0.0f, 1.0f, 0.0f });
-    return proj * view;
+    return getProjectionMatrix() * getLookAtMatrix();
+}
+
+glm::mat4 Camera::getLookAtMatrix(void) {
+    return glm::lookAt(m_Position, m_Position + m_Front, {0.0f, 1.0f, 0.0f });
+}
+
+glm::mat4 Camera::getProjectionMatrix(void) {
+    return glm::perspective(m_FOV, m_Ratio, m_Near, m_Far);
+}
+
+glm::vec3 Camera::getEyePosition(void) {
+    return m_Position;
+}
+
+void Camera::upload(void) {
+    frame::SetCamera(getLookAtMatrix(), getProjectionMatrix(), getEyePosition());
 }
 
 void Camera::reset() {
@@ -1,4 +1,5 @@
 #include "camera2D.h"
+#include "frame.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -6,13 +7,25 @@ namespace GRender
 {
 
     glm::mat4 Camera2D::getViewMatrix(void)
+    {
+        return getProjectionMatrix() * getLookAtMatrix();
+    } // getViewMatrix
+
+    glm::mat4 Camera2D::getLookAtMatrix(void)
     {
         glm::vec3 front(0.0, 0.0, -1.0), up(0.0, 1.0, 0.0);
-        glm::mat4 proj = glm::perspective(1.5707963f, aspect, fNear, fFar);
-        glm::mat4 view = glm::lookAt(position, position + front, up);
+        return glm::lookAt(position, position + front, up);
+    }
 
-        return proj * view;
-    } // getViewMatrix
+    glm::mat4 Camera2D::getProjectionMatrix(void)
+    {
+        return glm::perspective(1.5707963f, aspect, fNear, fFar);
+    }
+
+    void Camera2D::upload(void)
+    {
+        frame::SetCamera(getLookAtMatrix(), getProjectionMatrix(), position);
+    }
 
     void Camera2D::moveFront(float elapsed)
     {
@@ -0,0 +1,449 @@
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "compression.h"
+
+#include "stb_image.h"
+
+namespace GRender::compression {
+using namespace texture;
+
+// 4x4 texels, rows in the same order as the image
+using Block = std::array<std::array<int, 4>, 16>;
+
+static void fetchBlock(const uint8_t* pixels, const glm::uvec2& size, uint32_t bx, uint32_t by, Block& block) {
+    for (uint32_t k = 0; k < 16; k++) {
+        const uint32_t x = std::min(4 * bx + k % 4, size.x - 1);
+        const uint32_t y = std::min(4 * by + k / 4, size.y - 1);
+        const uint8_t* texel = pixels + 4 * (size_t(y) * size.x + x);
+        for (int c = 0; c < 4; c++) { block[k][c] = texel[c]; }
+    }
+}
+
+static void write16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+}
+
+// Bounding box corners along the main diagonal of the texels. Channels decreasing while the
+// widest one increases get their min and max swapped, so endpoints follow the actual gradient
+static void fitEndpoints(const Block& block, int numChannels, int lo[4], int hi[4]) {
+    int mean[4] = {};
+    for (int c = 0; c < numChannels; c++) {
+        lo[c] = 255;
+        hi[c] = 0;
+        for (const auto& texel : block) {
+            lo[c] = std::min(lo[c], texel[c]);
+            hi[c] = std::max(hi[c], texel[c]);
+            mean[c] += texel[c];
+        }
+    }
+
+    int widest = 0;
+    for (int c = 1; c < numChannels; c++) {
+        if (hi[c] - lo[c] > hi[widest] - lo[widest]) { widest = c; }
+    }
+
+    for (int c = 0; c < numChannels; c++) {
+        int covariance = 0;
+        for (const auto& texel : block) { covariance += (16 * texel[c] - mean[c]) * (16 * texel[widest] - mean[widest]); }
+        if (covariance < 0) { std::swap(lo[c], hi[c]); }
+    }
+}
+
+// BC1 //////////////////////////////////////////////////////////////////////
+
+static uint16_t to565(const int color[3]) {
+    return uint16_t(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | (color[2] * 31 + 127) / 255);
+}
+
+static void from565(uint16_t value, int color[3]) {
+    const int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Endpoints are corners of the color bounding box, always in four colors mode
+static void encodeColor(const Block& block, uint8_t* out) {
+    int lo[4], hi[4];
+    fitEndpoints(block, 3, lo, hi);
+
+    // Insetting the box a little lowers the error of interpolated colors
+    for (int c = 0; c < 3; c++) {
+        const int inset = (hi[c] - lo[c]) / 16;
+        lo[c] += inset;
+        hi[c] -= inset;
+    }
+
+    uint16_t c0 = to565(hi), c1 = to565(lo);
+    if (c0 < c1) { std::swap(c0, c1); }
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][3];
+        from565(c0, palette[0]);
+        from565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (uint32_t k = 0; k < 16; k++) {
+            uint32_t best = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (uint32_t id = 0; id < 4; id++) {
+                int error = 0;
+                for (int c = 0; c < 3; c++) {
+                    const int diff = block[k][c] - palette[id][c];
+                    error += diff * diff;
+                }
+                if (error < bestError) {
+                    bestError = error;
+                    best = id;
+                }
+            }
+            indices |= best << (2 * k);
+        }
+    }
+
+    write16(out, c0);
+    write16(out + 2, c1);
+    for (int b = 0; b < 4; b++) { out[4 + b] = (indices >> (8 * b)) & 0xFF; }
+}
+
+// BC3 //////////////////////////////////////////////////////////////////////
+
+// Alpha endpoints are min and max, interpolating six values between them
+static void encodeAlpha(const Block& block, uint8_t* out) {
+    int lo = 255, hi = 0;
+    for (const auto& texel : block) {
+        lo = std::min(lo, texel[3]);
+        hi = std::max(hi, texel[3]);
+    }
+
+    uint64_t indices = 0;
+    if (hi > lo) {
+        int palette[8] = { hi, lo };
+        for (int k = 1; k < 7; k++) { palette[k + 1] = ((7 - k) * hi + k * lo) / 7; }
+
+        for (uint32_t k = 0; k < 16; k++) {
+            uint64_t best = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for (uint32_t id = 0; id < 8; id++) {
+                const int error = std::abs(block[k][3] - palette[id]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = id;
+                }
+            }
+            indices |= best << (3 * k);
+        }
+    }
+
+    out[0] = uint8_t(hi);
+    out[1] = uint8_t(lo);
+    for (int b = 0; b < 6; b++) { out[2 + b] = (indices >> (8 * b)) & 0xFF; }
+}
+
+// BC7 //////////////////////////////////////////////////////////////////////
+
+// Fields are packed from the least significant bit of the first byte
+struct BitWriter {
+    uint8_t* out;
+    uint32_t pos = 0;
+
+    void put(uint32_t value, uint32_t numBits) {
+        for (uint32_t b = 0; b < numBits; b++, pos++) {
+            if ((value >> b) & 1) { out[pos / 8] |= uint8_t(1 << (pos % 8)); }
+        }
+    }
+};
+
+static constexpr int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static int bc7Interpolate(int e0, int e1, int id) {
+    return ((64 - bc7Weights[id]) * e0 + bc7Weights[id] * e1 + 32) >> 6;
+}
+
+// Endpoint with 7 bits per channel plus a shared low bit, picking the bit with lower error
+static int bc7Quantize(const int target[4], int quantized[4]) {
+    int bestBit = 0, bestError = std::numeric_limits<int>::max();
+    for (int p = 0; p < 2; p++) {
+        int error = 0, values[4];
+        for (int c = 0; c < 4; c++) {
+            values[c] = std::clamp((target[c] - p + 1) >> 1, 0, 127);
+            const int diff = ((values[c] << 1) | p) - target[c];
+            error += diff * diff;
+        }
+        if (error < bestError) {
+            bestError = error;
+            bestBit = p;
+            std::copy(values, values + 4, quantized);
+        }
+    }
+    return bestBit;
+}
+
+// Mode 6 only: one subset, RGBA endpoints and 16 interpolated colors. Good enough for photos
+// and much simpler than searching all modes and partitions
+static void encodeBC7(const Block& block, uint8_t* out) {
+    int lo[4], hi[4];
+    fitEndpoints(block, 4, lo, hi);
+
+    int quantized[2][4], bits[2], endpoints[2][4];
+    bits[0] = bc7Quantize(lo, quantized[0]);
+    bits[1] = bc7Quantize(hi, quantized[1]);
+    for (int e = 0; e < 2; e++) {
+        for (int c = 0; c < 4; c++) { endpoints[e][c] = (quantized[e][c] << 1) | bits[e]; }
+    }
+
+    // Projecting onto the endpoint axis gives a first guess, neighbours fix rounding
+    int dir[4], length = 0;
+    for (int c = 0; c < 4; c++) {
+        dir[c] = endpoints[1][c] - endpoints[0][c];
+        length += dir[c] * dir[c];
+    }
+
+    uint32_t indices[16] = {};
+    for (uint32_t k = 0; k < 16 && length > 0; k++) {
+        int proj = 0;
+        for (int c = 0; c < 4; c++) { proj += (block[k][c] - endpoints[0][c]) * dir[c]; }
+        const int guess = std::clamp(int(std::lround(15.0 * proj / length)), 0, 15);
+
+        int bestError = std::numeric_limits<int>::max();
+        for (int id = std::max(guess - 1, 0); id <= std::min(guess + 1, 15); id++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                const int diff = block[k][c] - bc7Interpolate(endpoints[0][c], endpoints[1][c], id);
+                error += diff * diff;
+            }
+            if (error < bestError) {
+                bestError = error;
+                indices[k] = id;
+            }
+        }
+    }
+
+    // First index is stored with 3 bits, so its top bit must be zero. Weights are symmetric,
+    // so swapping endpoints and flipping indices gives the same colors
+    if (indices[0] & 8) {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(bits[0], bits[1]);
+        for (uint32_t& id : indices) { id = 15 - id; }
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter writer{ out };
+    writer.put(1 << 6, 7);
+    for (int c = 0; c < 4; c++) {
+        writer.put(quantized[0][c], 7);
+        writer.put(quantized[1][c], 7);
+    }
+    writer.put(bits[0], 1);
+    writer.put(bits[1], 1);
+    writer.put(indices[0], 3);
+    for (uint32_t k = 1; k < 16; k++) { writer.put(indices[k], 4); }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+std::vector<uint8_t> encode(const uint8_t* pixels, const glm::uvec2& size, Format fmt) {
+    ASSERT(IsCompressed(fmt), "Expected compressed texture format!!");
+    ASSERT(size.x > 0 && size.y > 0, "Cannot compress empty image!!");
+
+    const glm::uvec2 numBlocks = (size + 3u) / 4u;
+    const size_t blockBytes = NumBytes(fmt, { 4, 4 });
+    std::vector<uint8_t> output(NumBytes(fmt, size));
+
+    // Block rows are independent, so threads simply interleave them
+    auto work = [&](uint32_t first, uint32_t stride) {
+        Block block;
+        for (uint32_t by = first; by < numBlocks.y; by += stride) {
+            uint8_t* out = output.data() + size_t(by) * numBlocks.x * blockBytes;
+            for (uint32_t bx = 0; bx < numBlocks.x; bx++, out += blockBytes) {
+                fetchBlock(pixels, size, bx, by, block);
+                switch (fmt) {
+                case Format::BC1: encodeColor(block, out); break;
+                case Format::BC3: encodeAlpha(block, out); encodeColor(block, out + 8); break;
+                default:          encodeBC7(block, out); break;
+                }
+            }
+        }
+    };
+
+    const uint32_t numThreads = std::clamp(std::thread::hardware_concurrency(), 1u, numBlocks.y);
+    std::vector<std::thread> threads;
+    for (uint32_t k = 1; k < numThreads; k++) { threads.emplace_back(work, k, numThreads); }
+    work(0, numThreads);
+    for (std::thread& thread : threads) { thread.join(); }
+
+    return output;
+}
+
+// Averages 2x2 texels, clamping at the border so odd sizes still work
+static std::vector<uint8_t> downsample(const uint8_t* pixels, const glm::uvec2& size) {
+    const glm::uvec2 half = glm::max(size / 2u, glm::uvec2(1));
+    std::vector<uint8_t> output(4 * size_t(half.x) * half.y);
+
+    for (uint32_t y = 0; y < half.y; y++) {
+        const uint32_t y0 = std::min(2 * y, size.y - 1), y1 = std::min(2 * y + 1, size.y - 1);
+        for (uint32_t x = 0; x < half.x; x++) {
+            const uint32_t x0 = std::min(2 * x, size.x - 1), x1 = std::min(2 * x + 1, size.x - 1);
+            for (uint32_t c = 0; c < 4; c++) {
+                const uint32_t sum = pixels[4 * (size_t(y0) * size.x + x0) + c] + pixels[4 * (size_t(y0) * size.x + x1) + c]
+                                   + pixels[4 * (size_t(y1) * size.x + x0) + c] + pixels[4 * (size_t(y1) * size.x + x1) + c];
+                output[4 * (size_t(y) * half.x + x) + c] = uint8_t((sum + 2) / 4);
+            }
+        }
+    }
+
+    return output;
+}
+
+Image encodeMipChain(const uint8_t* pixels, const glm::uvec2& size, Format fmt, uint32_t numLevels) {
+    const uint32_t maxLevels = 1 + static_cast<uint32_t>(std::log2(std::max({ size.x, size.y, 1u })));
+    numLevels = numLevels == 0 ? maxLevels : std::min(numLevels, maxLevels);
+
+    Image image;
+    image.fmt = fmt;
+    image.size = size;
+    image.levels.push_back(encode(pixels, size, fmt));
+
+    std::vector<uint8_t> current;
+    glm::uvec2 levelSize = size;
+    for (uint32_t level = 1; level < numLevels; level++) {
+        current = downsample(level == 1 ? pixels : current.data(), levelSize);
+        levelSize = glm::max(levelSize / 2u, glm::uvec2(1));
+        image.levels.push_back(encode(current.data(), levelSize, fmt));
+    }
+
+    return image;
+}
+
+uint64_t hashFile(const fs::path& filepath) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file) { return 0; }
+
+    uint64_t hash = 14695981039346656037ull;
+    std::vector<char> chunk(1 << 16);
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        for (std::streamsize k = 0; k < file.gcount(); k++) {
+            hash = (hash ^ uint8_t(chunk[k])) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// Container is a header followed by all levels, level 0 first
+struct Header {
+    char magic[4] = { 'G', 'R', 'B', 'C' };
+    uint32_t version = 1;
+    uint64_t sourceHash = 0;
+    uint32_t format = 0, width = 0, height = 0, numLevels = 0;
+};
+
+bool save(const fs::path& filepath, const Image& image, uint64_t sourceHash) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) { return false; }
+
+    Header header;
+    header.sourceHash = sourceHash;
+    header.format = static_cast<uint32_t>(image.fmt);
+    header.width = image.size.x;
+    header.height = image.size.y;
+    header.numLevels = static_cast<uint32_t>(image.levels.size());
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    for (const auto& level : image.levels) {
+        file.write(reinterpret_cast<const char*>(level.data()), level.size());
+    }
+    return file.good();
+}
+
+bool load(const fs::path& filepath, uint64_t sourceHash, Image& image) {
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file) { return false; }
+
+    Header header, expected;
+    file.read(reinterpret_cast<char*>(&header), sizeof(Header));
+    if (!file || std::memcmp(header.magic, expected.magic, 4) != 0 || header.version != expected.version) { return false; }
+
+    const Format fmt = static_cast<Format>(header.format);
+    if (header.sourceHash != sourceHash || !IsCompressed(fmt)) { return false; }
+    if (header.width == 0 || header.height == 0 || header.numLevels == 0 || header.numLevels > 32) { return false; }
+
+    image.fmt = fmt;
+    image.size = { header.width, header.height };
+    image.levels.resize(header.numLevels);
+    for (uint32_t level = 0; level < header.numLevels; level++) {
+        image.levels[level].resize(NumBytes(fmt, glm::max(image.size >> level, glm::uvec2(1))));
+        file.read(reinterpret_cast<char*>(image.levels[level].data()), image.levels[level].size());
+    }
+    return bool(file);
+}
+
+Texture createTexture(const Image& image, Specification spec) {
+    ASSERT(IsCompressed(image.fmt) && !image.levels.empty(), "Invalid compressed image!!");
+
+    spec.fmt = image.fmt;
+    spec.levels = static_cast<uint32_t>(image.levels.size());
+
+    Texture texture(image.size, spec);
+    for (uint32_t level = 0; level < texture.levels(); level++) {
+        texture.updateLevel(level, image.levels[level].data());
+    }
+    return texture;
+}
+
+} // namespace GRender::compression
+
+namespace GRender::utils {
+
+static std::string_view formatName(texture::Format fmt) {
+    switch (fmt) {
+    case texture::Format::BC1: return "bc1";
+    case texture::Format::BC3: return "bc3";
+    case texture::Format::BC7: return "bc7";
+    default:                   return "none";
+    }
+}
+
+Texture createCompressedTextureFromFile(const fs::path& filepath, const fs::path& cacheDirectory, texture::Specification spec) {
+    ASSERT(fs::is_regular_file(filepath), "File not found: " + filepath.string());
+    ASSERT(texture::IsCompressed(spec.fmt), "Expected compressed texture format specification!!");
+
+    // Same contents give the same name, wherever the file lives
+    const uint64_t hash = compression::hashFile(filepath);
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec
+         << "_" << formatName(spec.fmt) << "_" << spec.levels << ".gbc";
+    const fs::path cachePath = cacheDirectory / name.str();
+
+    compression::Image image;
+    if (compression::load(cachePath, hash, image) && image.fmt == spec.fmt) {
+        return compression::createTexture(image, spec);
+    }
+
+    int width, height, nrChannels;
+    stbi_set_flip_vertically_on_load(1);
+    uint8_t* data = stbi_load(filepath.string().c_str(), &width, &height, &nrChannels, 4);
+    ASSERT(data, "Failed to decode image :: " + filepath.string());
+    if (data == nullptr) { return Texture(); }
+
+    image = compression::encodeMipChain(data, { width, height }, spec.fmt, spec.levels);
+    stbi_image_free(data);
+
+    std::error_code error;
+    fs::create_directories(cacheDirectory, error);
+    if (!compression::save(cachePath, image, hash)) { WARN("Cannot write compressed texture cache :: " + cachePath.string()); }
+
+    return compression::createTexture(image, spec);
+}
+
+} // namespace GRender::utils
@@ -1,6 +1,7 @@
 #include "computeShader.h"
 #include "texture.h"
 #include "storageBuffer.h"
+#include "glState.h"
 
 namespace fs = std::filesystem;
 
@@ -20,22 +21,27 @@ static GLenum convertToGLFormat(texture::Format fmt) {
 }
 
 
-ComputeShader::ComputeShader(const fs::path& computePath) {
-    ASSERT(fs::exists(computePath), "Compute shader not found! => " + computePath.string());
-    uint32_t cmp = shader::internal::CreateShader(computePath, GL_COMPUTE_SHADER);
-
-    m_ProgramID = glCreateProgram();
-    glAttachShader(m_ProgramID, cmp);
-    glLinkProgram(m_ProgramID);
-    glDeleteShader(cmp);
+static GLenum convertToGLAccess(shader::Access access) {
+    switch (access) {
+    case shader::Access::READ_ONLY:  return GL_READ_ONLY;
+    case shader::Access::WRITE_ONLY: return GL_WRITE_ONLY;
+    default:                         return GL_READ_WRITE;
+    }
 }
 
-ComputeShader::~ComputeShader(void) {
-    glDeleteProgram(m_ProgramID);
-}
+ComputeShader::ComputeShader(const fs::path& computePath, const shader::Defines& defines)
+    : ComputeShader(shader::Source{ shader::internal::ReadShaderFile(computePath), computePath.string() }, defines) {}
+
+ComputeShader::ComputeShader(const shader::Source& compute, const shader::Defines& defines)
+    : m_Program({ { GL_COMPUTE_SHADER, compute } }, defines) {}
+
+ComputeShader::~ComputeShader(void) = default;
 
 ComputeShader::ComputeShader(ComputeShader&& shader) noexcept {
-    std::swap(m_ProgramID, shader.m_ProgramID);
+    std::swap(m_Program, shader.m_Program);
+    std::swap(m_Images, shader.m_Images);
+    std::swap(m_Buffers, shader.m_Buffers);
+    std::swap(m_GroupSize, shader.m_GroupSize);
 }
 
 ComputeShader& ComputeShader::operator=(ComputeShader&& shader) noexcept {
@@ -46,26 +52,126 @@ ComputeShader& ComputeShader::operator=(ComputeShader&& shader) noexcept {
     return *this;
 }
 
-void ComputeShader::setTexture(const Texture& tex, uint32_t slot) const {
+shader::UniformHandle ComputeShader::uniform(const std::string& name) const {
+    return m_Program.uniform(name);
+}
+
+void ComputeShader::setTexture(const Texture& tex, uint32_t slot, shader::Access access, uint32_t level) const {
+    ASSERT(level < tex.levels(), "Texture doesn't have level " + std::to_string(level));
     GLenum fmt = convertToGLFormat(tex.specification().fmt);
-    
-    tex.bind(slot);
-    glBindImageTexture(slot, tex.id(), 0, GL_FALSE, 0, GL_READ_WRITE, fmt);
+
+    gl::BindImageTexture(slot, tex.id(), static_cast<int32_t>(level), false, 0, convertToGLAccess(access), fmt);
+    m_Images[slot] = { tex.id(), access };
 }
 
-void ComputeShader::setBuffer(const StorageBuffer& buffer, uint32_t slot) const {
+void ComputeShader::setBuffer(const StorageBuffer& buffer, uint32_t slot, shader::Access access) const {
     buffer.bind(slot);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, slot, buffer.id());
+    m_Buffers[slot] = { buffer.id(), access };
 }
 
 const ComputeShader& ComputeShader::bind() {
-    glUseProgram(m_ProgramID);
+    gl::UseProgram(m_Program.id());
     return *this;
 }
 
 void ComputeShader::dispatch(uint32_t numGroupsX, uint32_t numGroupsY, uint32_t numGroupsZ) const {
+    waitForWrites(0);
     glDispatchCompute(numGroupsX, numGroupsY, numGroupsZ);
-    glMemoryBarrier(GL_ALL_BARRIER_BITS);
+    recordWrites();
+}
+
+void ComputeShader::dispatchIndirect(const StorageBuffer& args, size_t offset) const {
+    ASSERT(args, "StorageBuffer not initialized!!");
+    ASSERT(offset % 4 == 0 && offset + 3 * sizeof(uint32_t) <= args.numBytes(), "Invalid indirect dispatch offset!!");
+
+    waitForWrites(gl::PendingBarriers(gl::Resource::BUFFER, args.id(), GL_COMMAND_BARRIER_BIT));
+    gl::BindBuffer(GL_DISPATCH_INDIRECT_BUFFER, args.id());
+    glDispatchComputeIndirect(static_cast<GLintptr>(offset));
+    recordWrites();
+}
+
+void ComputeShader::waitForWrites(GLbitfield barriers) const {
+    // Waiting only for previous writes into our own resources
+    for (auto& [slot, image] : m_Images) {
+        barriers |= gl::PendingBarriers(gl::Resource::TEXTURE, image.id, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+    for (auto& [slot, buffer] : m_Buffers) {
+        barriers |= gl::PendingBarriers(gl::Resource::BUFFER, buffer.id, GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+    gl::IssueBarriers(barriers);
+}
+
+void ComputeShader::recordWrites(void) const {
+    // Barriers for these are issued when someone consumes them
+    for (auto& [slot, image] : m_Images) {
+        if (image.access != shader::Access::READ_ONLY) { gl::MarkWritten(gl::Resource::TEXTURE, image.id); }
+    }
+    for (auto& [slot, buffer] : m_Buffers) {
+        if (buffer.access != shader::Access::READ_ONLY) { gl::MarkWritten(gl::Resource::BUFFER, buffer.id); }
+    }
+
+    // Bindings only describe a single dispatch, stale ones could even refer to deleted resources
+    m_Images.clear();
+    m_Buffers.clear();
+}
+
+void ComputeShader::dispatchThreads(const glm::uvec3& numThreads) const {
+    const glm::uvec3 size = workGroupSize();
+    const glm::uvec3 numGroups = (numThreads + size - 1u) / size;
+    dispatch(numGroups.x, numGroups.y, numGroups.z);
 }
 
-} // namespace GRender
\ No newline at end of file
+glm::uvec3 ComputeShader::workGroupSize(void) const {
+    if (m_GroupSize.x == 0) {
+        glm::ivec3 size(1);
+        glGetProgramiv(m_Program.id(), GL_COMPUTE_WORK_GROUP_SIZE, glm::value_ptr(size));
+        m_GroupSize = glm::uvec3(size);
+    }
+    return m_GroupSize;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+namespace compute {
+
+constexpr std::string_view dispatchArgsShader =
+    "#version 450 core                                                              \n"
+    "layout(local_size_x = 1) in;                                                   \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer Counter { uint counter[]; };       \n"
+    "layout(std430, binding = 1) writeonly buffer Arguments { uint args[]; };       \n"
+    "                                                                               \n"
+    "uniform uint u_CounterIndex;                                                   \n"
+    "uniform uint u_ArgsIndex;                                                      \n"
+    "uniform uint u_GroupSize;                                                      \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint count = counter[u_CounterIndex];                                      \n"
+    "    args[u_ArgsIndex + 0u] = (count + u_GroupSize - 1u) / u_GroupSize;         \n"
+    "    args[u_ArgsIndex + 1u] = 1u;                                               \n"
+    "    args[u_ArgsIndex + 2u] = 1u;                                               \n"
+    "}                                                                              \n";
+
+void WriteDispatchArgs(const StorageBuffer& counter, size_t counterOffset,
+                       const StorageBuffer& args, size_t argsOffset, uint32_t groupSize) {
+    ASSERT(counterOffset % 4 == 0 && argsOffset % 4 == 0, "Offsets must be multiple of 4 bytes!!");
+    ASSERT(groupSize > 0, "Group size must be positive!!");
+
+    // Compiled the first time it is needed and shared afterwards
+    static std::unique_ptr<ComputeShader> kernel = nullptr;
+    if (kernel == nullptr) {
+        kernel = std::make_unique<ComputeShader>(shader::Source{ dispatchArgsShader, "dispatchArgs.comp" });
+    }
+
+    kernel->bind();
+    kernel->setUniform("u_CounterIndex", static_cast<uint32_t>(counterOffset / 4));
+    kernel->setUniform("u_ArgsIndex", static_cast<uint32_t>(argsOffset / 4));
+    kernel->setUniform("u_GroupSize", groupSize);
+    kernel->setBuffer(counter, 0, shader::Access::READ_ONLY);
+    kernel->setBuffer(args, 1, shader::Access::WRITE_ONLY);
+    kernel->dispatch(1);
+}
+
+} // namespace compute
+
+} // namespace GRender
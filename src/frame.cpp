@@ -0,0 +1,64 @@
+#include "frame.h"
+#include "glState.h"
+
+namespace GRender::frame {
+
+static Data s_Data;
+static bool s_Dirty = true;
+static uint32_t s_BufferID = 0;
+
+void SetCamera(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& position) {
+    s_Data.view = view;
+    s_Data.projection = projection;
+    s_Data.viewProjection = projection * view;
+    s_Data.cameraPosition = glm::vec4{ position, 1.0f };
+    s_Dirty = true;
+}
+
+void SetViewProjection(const glm::mat4& viewProjection) {
+    // Renderers call this on every draw with the same matrix, so we avoid re-uploading it.
+    // Same matrix also means view and projection from SetCamera still match it
+    if (viewProjection == s_Data.viewProjection) { return; }
+
+    // Split is unknown, so the whole transform goes into projection
+    s_Data.viewProjection = viewProjection;
+    s_Data.view = glm::mat4(1.0f);
+    s_Data.projection = viewProjection;
+    s_Data.cameraPosition = glm::vec4{ 0.0f, 0.0f, 0.0f, 1.0f };
+    s_Dirty = true;
+}
+
+void SetViewport(const glm::uvec2& size) {
+    const glm::vec2 viewport{ size };
+    if (viewport == s_Data.viewport) { return; }
+
+    s_Data.viewport = viewport;
+    s_Dirty = true;
+}
+
+void SetTime(float time, float deltaTime) {
+    s_Data.time = time;
+    s_Data.deltaTime = deltaTime;
+    s_Dirty = true;
+}
+
+const Data& Current(void) {
+    return s_Data;
+}
+
+void Upload(void) {
+    if (s_BufferID == 0) {
+        // Buffer lives as long as the application, so we never delete it
+        glCreateBuffers(1, &s_BufferID);
+        glNamedBufferData(s_BufferID, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    // Filtered by the state cache, and protects us against user code using the same binding point
+    gl::BindBufferBase(GL_UNIFORM_BUFFER, BINDING, s_BufferID);
+    if (!s_Dirty) { return; }
+
+    glNamedBufferSubData(s_BufferID, 0, sizeof(Data), &s_Data);
+    s_Dirty = false;
+}
+
+} // namespace GRender::frame
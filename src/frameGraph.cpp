@@ -0,0 +1,423 @@
+#include <set>
+
+#include "frameGraph.h"
+#include "frame.h"
+#include "glState.h"
+
+namespace GRender {
+using namespace graph;
+
+// Pooled resources not used for this many frames are deleted
+constexpr uint64_t POOL_FRAMES = 2;
+
+// Barrier needed before this usage if resource was written by shader stores
+static GLbitfield barrierFor(Usage usage, bool isTexture) {
+    switch (usage) {
+    case Usage::SAMPLED:    return GL_TEXTURE_FETCH_BARRIER_BIT;
+    case Usage::IMAGE:      return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+    case Usage::STORAGE:    return GL_SHADER_STORAGE_BARRIER_BIT;
+    case Usage::ATTACHMENT: return GL_FRAMEBUFFER_BARRIER_BIT;
+    case Usage::INDIRECT:   return GL_COMMAND_BARRIER_BIT;
+    default:                return isTexture ? GL_TEXTURE_UPDATE_BARRIER_BIT : GL_BUFFER_UPDATE_BARRIER_BIT;
+    }
+}
+
+FrameGraph::~FrameGraph(void) {
+    for (auto& [key, target] : m_Targets) {
+        gl::DeleteFramebuffer(target.framebuffer);
+        glDeleteRenderbuffers(1, &target.depth);
+    }
+}
+
+void FrameGraph::beginFrame(void) {
+    if (!m_Executed) { return; }
+
+    // Outputs are kept until the next frame starts
+    for (Resource& res : m_Resources) { release(res); }
+    m_Passes.clear();
+    m_Resources.clear();
+    m_Executed = false;
+}
+
+Handle FrameGraph::importTexture(const std::string& name, const Texture& texture) {
+    ASSERT(texture, "Cannot import uninitialized texture :: " + name);
+    beginFrame();
+
+    Resource& res = m_Resources.emplace_back();
+    res.name = name;
+    res.imported = true;
+    res.size = texture.size();
+    res.spec = texture.specification();
+    res.texture = &texture;
+    return Handle{ static_cast<uint32_t>(m_Resources.size() - 1) };
+}
+
+Handle FrameGraph::importBuffer(const std::string& name, const StorageBuffer& buffer) {
+    ASSERT(buffer, "Cannot import uninitialized buffer :: " + name);
+    beginFrame();
+
+    Resource& res = m_Resources.emplace_back();
+    res.name = name;
+    res.isTexture = false;
+    res.imported = true;
+    res.numBytes = buffer.numBytes();
+    res.buffer = &buffer;
+    return Handle{ static_cast<uint32_t>(m_Resources.size() - 1) };
+}
+
+Handle FrameGraph::createTexture(const std::string& name, const glm::uvec2& size, const texture::Specification& spec) {
+    ASSERT(size.x > 0 && size.y > 0, "Invalid texture size :: " + name);
+    beginFrame();
+
+    Resource& res = m_Resources.emplace_back();
+    res.name = name;
+    res.size = size;
+    res.spec = spec;
+    return Handle{ static_cast<uint32_t>(m_Resources.size() - 1) };
+}
+
+Handle FrameGraph::createBuffer(const std::string& name, size_t numBytes) {
+    ASSERT(numBytes > 0, "Invalid buffer size :: " + name);
+    beginFrame();
+
+    Resource& res = m_Resources.emplace_back();
+    res.name = name;
+    res.isTexture = false;
+    res.numBytes = numBytes;
+    return Handle{ static_cast<uint32_t>(m_Resources.size() - 1) };
+}
+
+void FrameGraph::addPass(const std::string& name, const Setup& setup, const Execute& execute) {
+    beginFrame();
+
+    Pass& pass = m_Passes.emplace_back();
+    pass.name = name;
+    pass.execute = execute;
+
+    Builder builder(*this, pass);
+    setup(builder);
+}
+
+void FrameGraph::markOutput(Handle handle) {
+    ASSERT(handle.index < m_Resources.size(), "Invalid frame graph handle!!");
+    m_Resources[handle.index].output = true;
+}
+
+const Texture* FrameGraph::texture(Handle handle) const {
+    return handle.index < m_Resources.size() ? m_Resources[handle.index].texture : nullptr;
+}
+
+const StorageBuffer* FrameGraph::buffer(Handle handle) const {
+    return handle.index < m_Resources.size() ? m_Resources[handle.index].buffer : nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Readers depend on the last writer declared before them. Transient resources read before any
+// writer depend on the first one, so passes can be declared in any order. Writers are executed in
+// declaration order, after readers of the previous writer.
+// Only data dependencies keep passes alive, ordering ones just sort them.
+std::vector<uint32_t> FrameGraph::schedule(void) const {
+    const size_t numPasses = m_Passes.size();
+    std::vector<std::vector<std::pair<uint32_t, bool>>> deps(numPasses); // (pass, isData)
+
+    for (uint32_t r = 0; r < m_Resources.size(); r++) {
+        std::vector<uint32_t> writers;
+        for (uint32_t p = 0; p < numPasses; p++) {
+            for (const Access& acc : m_Passes[p].accesses) {
+                if (acc.resource == r && acc.write) { writers.push_back(p); break; }
+            }
+        }
+
+        for (uint32_t p = 0; p < numPasses; p++) {
+            bool reads = false, writes = false;
+            for (const Access& acc : m_Passes[p].accesses) {
+                if (acc.resource != r) { continue; }
+                (acc.write ? writes : reads) = true;
+            }
+            if (!reads && !writes) { continue; }
+
+            auto next = std::lower_bound(writers.begin(), writers.end(), p);
+            const bool hasPrevious = next != writers.begin();
+            const uint32_t previous = hasPrevious ? *(next - 1) : 0;
+
+            if (writes) {
+                // Chained writers keep order, and previous contents matter only if we read them
+                if (hasPrevious) { deps[p].emplace_back(previous, reads); }
+                continue;
+            }
+
+            if (hasPrevious) {
+                deps[p].emplace_back(previous, true);
+                if (next != writers.end()) { deps[*next].emplace_back(p, false); } // write after read
+            }
+            else if (!writers.empty()) {
+                if (m_Resources[r].imported) { deps[writers.front()].emplace_back(p, false); } // reads last frame
+                else { deps[p].emplace_back(writers.front(), true); }
+            }
+        }
+    }
+
+    // Culling: we keep passes with visible results and everything they need
+    std::vector<bool> needed(numPasses, false);
+    std::vector<uint32_t> stack;
+    for (uint32_t p = 0; p < numPasses; p++) {
+        bool root = m_Passes[p].sideEffect;
+        for (const Access& acc : m_Passes[p].accesses) {
+            const Resource& res = m_Resources[acc.resource];
+            root |= acc.write && (res.imported || res.output);
+        }
+        if (root) { needed[p] = true; stack.push_back(p); }
+    }
+
+    while (!stack.empty()) {
+        const uint32_t p = stack.back();
+        stack.pop_back();
+        for (auto [q, isData] : deps[p]) {
+            if (isData && !needed[q]) { needed[q] = true; stack.push_back(q); }
+        }
+    }
+
+    // Topological sort, declaration order breaks ties
+    std::vector<uint32_t> numDeps(numPasses, 0);
+    std::vector<std::vector<uint32_t>> dependents(numPasses);
+    for (uint32_t p = 0; p < numPasses; p++) {
+        if (!needed[p]) { continue; }
+        for (auto [q, isData] : deps[p]) {
+            if (!needed[q] || q == p) { continue; }
+            numDeps[p]++;
+            dependents[q].push_back(p);
+        }
+    }
+
+    std::set<uint32_t> ready;
+    for (uint32_t p = 0; p < numPasses; p++) {
+        if (needed[p] && numDeps[p] == 0) { ready.insert(p); }
+    }
+
+    std::vector<uint32_t> order;
+    while (!ready.empty()) {
+        const uint32_t p = *ready.begin();
+        ready.erase(ready.begin());
+        order.push_back(p);
+
+        for (uint32_t q : dependents[p]) {
+            if (--numDeps[q] == 0) { ready.insert(q); }
+        }
+    }
+
+    const size_t numNeeded = std::count(needed.begin(), needed.end(), true);
+    ASSERT(order.size() == numNeeded, "Frame graph has cyclic dependencies!!");
+    return order;
+}
+
+void FrameGraph::acquire(Resource& res) {
+    if (res.imported || res.texture || res.buffer) { return; }
+
+    if (res.isTexture) {
+        auto it = std::find_if(m_TexturePool.begin(), m_TexturePool.end(), [&](const PoolEntry<Texture>& entry) {
+            return !entry.inUse && entry.object.size() == res.size && entry.object.specification() == res.spec;
+        });
+        if (it == m_TexturePool.end()) { it = m_TexturePool.insert(m_TexturePool.end(), { Texture(res.size, res.spec) }); }
+
+        it->inUse = true;
+        it->lastFrame = m_Frame;
+        res.texture = &it->object;
+    }
+    else {
+        auto it = std::find_if(m_BufferPool.begin(), m_BufferPool.end(), [&](const PoolEntry<StorageBuffer>& entry) {
+            return !entry.inUse && entry.object.numBytes() == res.numBytes;
+        });
+        if (it == m_BufferPool.end()) { it = m_BufferPool.insert(m_BufferPool.end(), { StorageBuffer(res.numBytes) }); }
+
+        it->inUse = true;
+        it->lastFrame = m_Frame;
+        res.buffer = &it->object;
+    }
+}
+
+// Pointers are kept, so results can still be queried until next frame
+void FrameGraph::release(Resource& res) {
+    if (res.imported) { return; }
+
+    for (auto& entry : m_TexturePool) {
+        if (&entry.object == res.texture) { entry.inUse = false; }
+    }
+    for (auto& entry : m_BufferPool) {
+        if (&entry.object == res.buffer) { entry.inUse = false; }
+    }
+}
+
+void FrameGraph::bindTarget(const Pass& pass) {
+    std::vector<uint32_t> key;
+    glm::uvec2 size = { 0, 0 };
+    for (const Access& acc : pass.accesses) {
+        if (!acc.write || acc.usage != Usage::ATTACHMENT) { continue; }
+
+        const Texture* tex = m_Resources[acc.resource].texture;
+        ASSERT(size == glm::uvec2(0) || size == tex->size(), "Attachments with different sizes in pass :: " + pass.name);
+        size = tex->size();
+        key.push_back(tex->id());
+    }
+    key.push_back(pass.depth ? 1 : 0);
+
+    Target& target = m_Targets[key];
+    target.lastFrame = m_Frame;
+    if (target.framebuffer == 0) {
+        glCreateFramebuffers(1, &target.framebuffer);
+
+        std::vector<GLenum> buffers(key.size() - 1);
+        for (size_t k = 0; k < buffers.size(); k++) { buffers[k] = GL_COLOR_ATTACHMENT0 + uint32_t(k); }
+        glNamedFramebufferDrawBuffers(target.framebuffer, uint32_t(buffers.size()), buffers.data());
+    }
+
+    // Resized textures usually get the same id back, so we attach them again every time. Otherwise
+    // framebuffer would keep rendering into the old storage
+    for (size_t k = 0; k + 1 < key.size(); k++) {
+        glNamedFramebufferTexture(target.framebuffer, GL_COLOR_ATTACHMENT0 + uint32_t(k), key[k], 0);
+    }
+
+    if (pass.depth && target.size != size) {
+        glDeleteRenderbuffers(1, &target.depth);
+        glCreateRenderbuffers(1, &target.depth);
+        glNamedRenderbufferStorage(target.depth, GL_DEPTH_COMPONENT32F, size.x, size.y);
+        glNamedFramebufferRenderbuffer(target.framebuffer, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth);
+    }
+    target.size = size;
+
+    ASSERT(glCheckNamedFramebufferStatus(target.framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE,
+           "Framebuffer is incomplete in pass :: " + pass.name);
+
+    gl::BindFramebuffer(target.framebuffer);
+    gl::Viewport(0, 0, size.x, size.y);
+    frame::SetViewport(size);
+}
+
+void FrameGraph::collectGarbage(void) {
+    // Framebuffers go first, as they may reference pooled textures
+    for (auto it = m_Targets.begin(); it != m_Targets.end();) {
+        if (it->second.lastFrame == m_Frame) { it++; continue; }
+        gl::DeleteFramebuffer(it->second.framebuffer);
+        glDeleteRenderbuffers(1, &it->second.depth);
+        it = m_Targets.erase(it);
+    }
+
+    m_TexturePool.remove_if([&](const PoolEntry<Texture>& entry) { return !entry.inUse && m_Frame - entry.lastFrame >= POOL_FRAMES; });
+    m_BufferPool.remove_if([&](const PoolEntry<StorageBuffer>& entry) { return !entry.inUse && m_Frame - entry.lastFrame >= POOL_FRAMES; });
+}
+
+void FrameGraph::execute(void) {
+    ASSERT(!m_Executed, "Frame graph was already executed, declare passes for the next frame!!");
+
+    const std::vector<uint32_t> order = schedule();
+
+    // Lifetimes of transient resources in execution order
+    constexpr size_t NONE = std::numeric_limits<size_t>::max();
+    std::vector<size_t> first(m_Resources.size(), NONE), last(m_Resources.size(), 0);
+    for (size_t pos = 0; pos < order.size(); pos++) {
+        for (const Access& acc : m_Passes[order[pos]].accesses) {
+            first[acc.resource] = std::min(first[acc.resource], pos);
+            last[acc.resource] = m_Resources[acc.resource].output ? NONE : pos;
+        }
+    }
+
+    // Passes rendering to attachments leave the caller's framebuffer bound afterwards, e.g. a viewport
+    bool saved = false;
+    uint32_t callerFramebuffer = 0;
+    glm::ivec4 callerViewport(0);
+
+    m_Order.clear();
+    const Resources resources(*this);
+    for (size_t pos = 0; pos < order.size(); pos++) {
+        const Pass& pass = m_Passes[order[pos]];
+        m_Order.push_back(pass.name);
+
+        GLbitfield barriers = 0;
+        bool hasTarget = false;
+        for (const Access& acc : pass.accesses) {
+            Resource& res = m_Resources[acc.resource];
+            if (first[acc.resource] == pos) { acquire(res); }
+
+            const gl::Resource type = res.isTexture ? gl::Resource::TEXTURE : gl::Resource::BUFFER;
+            const uint32_t id = res.isTexture ? res.texture->id() : res.buffer->id();
+            barriers |= gl::PendingBarriers(type, id, barrierFor(acc.usage, res.isTexture));
+            hasTarget |= acc.write && acc.usage == Usage::ATTACHMENT;
+        }
+        gl::IssueBarriers(barriers);
+
+        if (hasTarget && !saved) {
+            callerFramebuffer = gl::CurrentFramebuffer();
+            callerViewport = gl::CurrentViewport();
+            saved = true;
+        }
+
+        if (hasTarget) { bindTarget(pass); }
+        pass.execute(resources);
+        if (hasTarget) {
+            gl::BindFramebuffer(callerFramebuffer);
+            gl::Viewport(callerViewport.x, callerViewport.y, callerViewport.z, callerViewport.w);
+            frame::SetViewport({ callerViewport.z, callerViewport.w });
+        }
+
+        for (const Access& acc : pass.accesses) {
+            Resource& res = m_Resources[acc.resource];
+
+            // Shader stores are incoherent, so next consumers will need a barrier
+            if (acc.write && (acc.usage == Usage::IMAGE || acc.usage == Usage::STORAGE)) {
+                const gl::Resource type = res.isTexture ? gl::Resource::TEXTURE : gl::Resource::BUFFER;
+                gl::MarkWritten(type, res.isTexture ? res.texture->id() : res.buffer->id());
+            }
+
+            if (last[acc.resource] == pos) { release(res); }
+        }
+    }
+
+    collectGarbage();
+    m_Frame++;
+    m_Executed = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace graph {
+
+Handle Builder::createTexture(const std::string& name, const glm::uvec2& size, const texture::Specification& spec) {
+    return m_Graph.createTexture(name, size, spec);
+}
+
+Handle Builder::createBuffer(const std::string& name, size_t numBytes) {
+    return m_Graph.createBuffer(name, numBytes);
+}
+
+Handle Builder::read(Handle handle, Usage usage) {
+    ASSERT(handle.index < m_Graph.m_Resources.size(), "Invalid frame graph handle in pass :: " + m_Pass.name);
+    ASSERT(usage != Usage::ATTACHMENT, "Attachments can only be written :: " + m_Pass.name);
+    m_Pass.accesses.push_back({ handle.index, usage, false });
+    return handle;
+}
+
+Handle Builder::write(Handle handle, Usage usage) {
+    ASSERT(handle.index < m_Graph.m_Resources.size(), "Invalid frame graph handle in pass :: " + m_Pass.name);
+    ASSERT(usage != Usage::ATTACHMENT || m_Graph.m_Resources[handle.index].isTexture, "Only textures can be attachments :: " + m_Pass.name);
+    m_Pass.accesses.push_back({ handle.index, usage, true });
+    return handle;
+}
+
+void Builder::useDepth(void) { m_Pass.depth = true; }
+void Builder::sideEffect(void) { m_Pass.sideEffect = true; }
+
+const Texture& Resources::texture(Handle handle) const {
+    const Texture* tex = m_Graph.texture(handle);
+    ASSERT(tex, "Texture not available in this pass!!");
+    return *tex;
+}
+
+const StorageBuffer& Resources::buffer(Handle handle) const {
+    const StorageBuffer* buf = m_Graph.buffer(handle);
+    ASSERT(buf, "Buffer not available in this pass!!");
+    return *buf;
+}
+
+} // namespace graph
+
+} // namespace GRender
@@ -1,5 +1,7 @@
 #include "framebuffer.h"
 
+#include "frame.h"
+#include "glState.h"
 #include "texture.h"
 
 namespace GRender {
@@ -8,8 +10,7 @@ using TexSpec = texture::Specification;
 Framebuffer::Framebuffer(const glm::uvec2& size, const std::vector<TexSpec>& vSpecs,  bool createDepthBuf)
     : m_HasDepthBuffer(createDepthBuf), m_Size(size) {
 
-    glGenFramebuffers(1, &m_BufferID);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_BufferID);
+    glCreateFramebuffers(1, &m_BufferID);
 
     // Creating textures for all color attachments
     std::vector<GLenum> buffers(vSpecs.size());
@@ -18,31 +19,27 @@ Framebuffer::Framebuffer(const glm::uvec2& size, const std::vector<TexSpec>& vSp
         auto& tex = m_Textures.emplace_back(size, spec);
 
         buffers[k] = GL_COLOR_ATTACHMENT0 + uint32_t(k);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, buffers[k], GL_TEXTURE_2D, tex.id(), 0);
+        glNamedFramebufferTexture(m_BufferID, buffers[k], tex.id(), 0);
     }
 
     // Telling OpenGL to draw in all attached buffers
-    glDrawBuffers(uint32_t(buffers.size()), buffers.data());
+    glNamedFramebufferDrawBuffers(m_BufferID, uint32_t(buffers.size()), buffers.data());
 
     // If necessary we also create a depth buffer
     if (createDepthBuf) {
-        glGenTextures(1, &m_DepthID);
-        glBindTexture(GL_TEXTURE_2D, m_DepthID);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, size.x, size.y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_DepthID, 0);
+        glCreateTextures(GL_TEXTURE_2D, 1, &m_DepthID);
+        glTextureStorage2D(m_DepthID, 1, GL_DEPTH_COMPONENT32F, size.x, size.y);
+        glNamedFramebufferTexture(m_BufferID, GL_DEPTH_ATTACHMENT, m_DepthID, 0);
     }
 
     // Testing if it worked properly
-    ASSERT(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!!");
-
-    // binding standard buffer back
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    ASSERT(glCheckNamedFramebufferStatus(m_BufferID, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE, "Framebuffer is incomplete!!");
 }
 
 Framebuffer::~Framebuffer(void) {
-    glDeleteTextures(1, &m_DepthID);
+    gl::DeleteTexture(m_DepthID);
     m_Textures.clear();
-    glDeleteFramebuffers(1, &m_BufferID);
+    gl::DeleteFramebuffer(m_BufferID);
 }
 
 Framebuffer::Framebuffer(Framebuffer&& fBuffer) noexcept {
@@ -68,12 +65,13 @@ const Texture& Framebuffer::texture(uint32_t id) const {
 
 void Framebuffer::bind(void) const {
     ASSERT(*this, "Framebuffer not defined!");
-    glBindFramebuffer(GL_FRAMEBUFFER, m_BufferID);
-    glViewport(0, 0, m_Size.x, m_Size.y);
+    gl::BindFramebuffer(m_BufferID);
+    gl::Viewport(0, 0, m_Size.x, m_Size.y);
+    frame::SetViewport(m_Size);
 }
 
 void Framebuffer::unbind(void) const {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl::BindFramebuffer(0);
 }
 
 void Framebuffer::resize(const glm::uvec2& size) {
@@ -0,0 +1,285 @@
+#include "glState.h"
+
+#include <array>
+#include <limits>
+
+namespace GRender::gl {
+
+// Marks bindings we know nothing about, so next call always reaches the driver
+constexpr uint32_t UNKNOWN = std::numeric_limits<uint32_t>::max();
+constexpr size_t MAX_UNITS = 32;
+
+struct Range {
+    uint32_t buffer = UNKNOWN;
+    GLintptr offset = -1;
+    GLsizeiptr size = -1;
+
+    bool operator==(const Range& o) const { return buffer == o.buffer && offset == o.offset && size == o.size; }
+};
+
+struct Image {
+    uint32_t texture = UNKNOWN;
+    int32_t level = -1, layer = -1;
+    bool layered = false;
+    GLenum access = 0, format = 0;
+
+    bool operator==(const Image& o) const {
+        return texture == o.texture && level == o.level && layered == o.layered && layer == o.layer && access == o.access && format == o.format;
+    }
+};
+
+struct State {
+    uint32_t program, vao, framebuffer;
+    glm::ivec4 viewport;
+
+    // Element buffer binding belongs to the VAO, so it is forgotten every time the VAO changes
+    uint32_t elementBuffer;
+    std::unordered_map<GLenum, uint32_t> buffers;
+
+    std::array<uint32_t, MAX_UNITS> textures;
+    std::array<Image, MAX_UNITS> images;
+    std::array<Range, MAX_UNITS> storage, uniform;
+
+    // Writes are ordered by epoch. A barrier bit covers every write issued before it
+    uint64_t epoch = 0;
+    std::array<uint64_t, 32> barrierEpoch = {};
+    std::unordered_map<uint64_t, uint64_t> writes;
+
+    Statistics stats;
+
+    State(void) { reset(); }
+
+    void reset(void) {
+        program = vao = framebuffer = elementBuffer = UNKNOWN;
+        viewport = glm::ivec4(-1);
+        buffers.clear();
+        textures.fill(UNKNOWN);
+        images.fill(Image{});
+        storage.fill(Range{});
+        uniform.fill(Range{});
+    }
+};
+
+static State s_State;
+
+// Updates cached value and returns true if call must be issued
+template <typename TP>
+static bool change(TP& cached, const TP& value) {
+    if (cached == value) {
+        s_State.stats.skipped++;
+        return false;
+    }
+    cached = value;
+    s_State.stats.issued++;
+    return true;
+}
+
+static uint64_t resourceKey(Resource type, uint32_t id) {
+    return (static_cast<uint64_t>(type) << 32) | id;
+}
+
+static std::array<Range, MAX_UNITS>* indexedBindings(GLenum target) {
+    switch (target) {
+    case GL_SHADER_STORAGE_BUFFER:
+        return &s_State.storage;
+    case GL_UNIFORM_BUFFER:
+        return &s_State.uniform;
+    default:
+        return nullptr;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void UseProgram(uint32_t program) {
+    if (change(s_State.program, program)) { glUseProgram(program); }
+}
+
+void BindVertexArray(uint32_t vao) {
+    if (change(s_State.vao, vao)) {
+        glBindVertexArray(vao);
+        s_State.elementBuffer = UNKNOWN;
+    }
+}
+
+void BindFramebuffer(uint32_t framebuffer) {
+    if (change(s_State.framebuffer, framebuffer)) { glBindFramebuffer(GL_FRAMEBUFFER, framebuffer); }
+}
+
+void Viewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+    if (change(s_State.viewport, glm::ivec4(x, y, width, height))) { glViewport(x, y, width, height); }
+}
+
+uint32_t CurrentFramebuffer(void) {
+    if (s_State.framebuffer == UNKNOWN) {
+        GLint framebuffer = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        s_State.framebuffer = static_cast<uint32_t>(framebuffer);
+    }
+    return s_State.framebuffer;
+}
+
+glm::ivec4 CurrentViewport(void) {
+    if (s_State.viewport == glm::ivec4(-1)) { glGetIntegerv(GL_VIEWPORT, glm::value_ptr(s_State.viewport)); }
+    return s_State.viewport;
+}
+
+void BindBuffer(GLenum target, uint32_t buffer) {
+    uint32_t& cached = target == GL_ELEMENT_ARRAY_BUFFER ? s_State.elementBuffer
+                                                         : s_State.buffers.try_emplace(target, UNKNOWN).first->second;
+    if (change(cached, buffer)) { glBindBuffer(target, buffer); }
+}
+
+void BindBufferBase(GLenum target, uint32_t index, uint32_t buffer) {
+    auto* bindings = indexedBindings(target);
+    if (bindings == nullptr || index >= MAX_UNITS) {
+        s_State.stats.issued++;
+        glBindBufferBase(target, index, buffer);
+    }
+    else if (change((*bindings)[index], Range{ buffer, 0, 0 })) {
+        glBindBufferBase(target, index, buffer);
+    }
+    else { return; }
+
+    // Indexed binds also replace the generic binding point
+    s_State.buffers[target] = buffer;
+}
+
+void BindBufferRange(GLenum target, uint32_t index, uint32_t buffer, GLintptr offset, GLsizeiptr size) {
+    auto* bindings = indexedBindings(target);
+    if (bindings == nullptr || index >= MAX_UNITS) {
+        s_State.stats.issued++;
+        glBindBufferRange(target, index, buffer, offset, size);
+    }
+    else if (change((*bindings)[index], Range{ buffer, offset, size })) {
+        glBindBufferRange(target, index, buffer, offset, size);
+    }
+    else { return; }
+
+    s_State.buffers[target] = buffer;
+}
+
+void BindTexture(uint32_t unit, uint32_t texture) {
+    if (unit >= MAX_UNITS) {
+        s_State.stats.issued++;
+        glBindTextureUnit(unit, texture);
+    }
+    else if (change(s_State.textures[unit], texture)) {
+        glBindTextureUnit(unit, texture);
+    }
+}
+
+void BindImageTexture(uint32_t unit, uint32_t texture, int32_t level, bool layered, int32_t layer, GLenum access, GLenum format) {
+    const Image image{ texture, level, layer, layered, access, format };
+    if (unit >= MAX_UNITS) {
+        s_State.stats.issued++;
+        glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    }
+    else if (change(s_State.images[unit], image)) {
+        glBindImageTexture(unit, texture, level, layered, layer, access, format);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MarkWritten(Resource type, uint32_t id) {
+    s_State.writes[resourceKey(type, id)] = ++s_State.epoch;
+}
+
+GLbitfield PendingBarriers(Resource type, uint32_t id, GLbitfield barriers) {
+    auto it = s_State.writes.find(resourceKey(type, id));
+    if (it == s_State.writes.end()) { return 0; }
+
+    GLbitfield pending = 0;
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if ((barriers & (1u << bit)) && s_State.barrierEpoch[bit] < it->second) { pending |= (1u << bit); }
+    }
+    return pending;
+}
+
+void IssueBarriers(GLbitfield barriers) {
+    if (barriers == 0) { return; }
+
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if (barriers & (1u << bit)) { s_State.barrierEpoch[bit] = s_State.epoch; }
+    }
+    s_State.stats.barriers++;
+    glMemoryBarrier(barriers);
+}
+
+void Consume(Resource type, uint32_t id, GLbitfield barriers) {
+    IssueBarriers(PendingBarriers(type, id, barriers));
+}
+
+void FlushBarriers(GLbitfield barriers) {
+    GLbitfield pending = 0;
+    for (uint32_t bit = 0; bit < 32; bit++) {
+        if ((barriers & (1u << bit)) && s_State.barrierEpoch[bit] < s_State.epoch) { pending |= (1u << bit); }
+    }
+    IssueBarriers(pending);
+}
+
+bool WaitFence(GLsync fence) {
+    // Polling first, so stalls are only counted when we really have to wait
+    GLenum status = glClientWaitSync(fence, 0, 0);
+    const bool stalled = status == GL_TIMEOUT_EXPIRED;
+
+    constexpr GLuint64 timeout = 1'000'000'000; // ns
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    }
+
+    ASSERT(status != GL_WAIT_FAILED, "Failed to wait for fence!!");
+    glDeleteSync(fence);
+    return stalled;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void DeleteProgram(uint32_t program) {
+    if (s_State.program == program) { s_State.program = UNKNOWN; }
+    glDeleteProgram(program);
+}
+
+void DeleteVertexArray(uint32_t vao) {
+    if (s_State.vao == vao) { s_State.vao = s_State.elementBuffer = UNKNOWN; }
+    glDeleteVertexArrays(1, &vao);
+}
+
+void DeleteFramebuffer(uint32_t framebuffer) {
+    if (s_State.framebuffer == framebuffer) { s_State.framebuffer = UNKNOWN; }
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void DeleteBuffer(uint32_t buffer) {
+    if (s_State.elementBuffer == buffer) { s_State.elementBuffer = UNKNOWN; }
+    for (auto& [target, id] : s_State.buffers) {
+        if (id == buffer) { id = UNKNOWN; }
+    }
+    for (Range& range : s_State.storage) {
+        if (range.buffer == buffer) { range = Range{}; }
+    }
+    for (Range& range : s_State.uniform) {
+        if (range.buffer == buffer) { range = Range{}; }
+    }
+    s_State.writes.erase(resourceKey(Resource::BUFFER, buffer));
+    glDeleteBuffers(1, &buffer);
+}
+
+void DeleteTexture(uint32_t texture) {
+    for (uint32_t& id : s_State.textures) {
+        if (id == texture) { id = UNKNOWN; }
+    }
+    for (Image& image : s_State.images) {
+        if (image.texture == texture) { image = Image{}; }
+    }
+    s_State.writes.erase(resourceKey(Resource::TEXTURE, texture));
+    glDeleteTextures(1, &texture);
+}
+
+void Invalidate(void) { s_State.reset(); }
+
+Statistics GetStatistics(void) { return s_State.stats; }
+void ResetStatistics(void) { s_State.stats = Statistics{}; }
+
+} // namespace GRender::gl
@@ -0,0 +1,557 @@
+#include <numeric>
+
+#include "gpu.h"
+#include "computeShader.h"
+#include "glState.h"
+
+namespace GRender::gpu {
+
+// Every workgroup processes a block of THREADS * PER_THREAD elements
+constexpr uint32_t THREADS = 256;
+constexpr uint32_t PER_THREAD = 4;
+constexpr size_t BLOCK = THREADS * PER_THREAD;
+constexpr uint32_t RADIX_BITS = 4;
+constexpr uint32_t RADIX = 1u << RADIX_BITS;
+
+// Grids wider than this are folded into the y dimension
+constexpr uint32_t MAX_GROUPS_X = 65535;
+
+constexpr std::string_view commonCode =
+    "#define THREADS 256u                                                           \n"
+    "#define PER_THREAD 4u                                                          \n"
+    "#define BLOCK (THREADS * PER_THREAD)                                           \n"
+    "layout(local_size_x = 256) in;                                                 \n"
+    "                                                                               \n"
+    "uint groupIndex() { return gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x; } \n"
+    "                                                                               \n"
+    "shared uint s_Scan[THREADS];                                                   \n"
+    "                                                                               \n"
+    "// Exclusive scan of one value per thread across the workgroup                 \n"
+    "uint groupExclusiveScan(uint value, out uint total) {                          \n"
+    "    uint t = gl_LocalInvocationID.x;                                           \n"
+    "    s_Scan[t] = value;                                                         \n"
+    "    barrier();                                                                 \n"
+    "    for (uint offset = 1u; offset < THREADS; offset <<= 1u) {                  \n"
+    "        uint add = t >= offset ? s_Scan[t - offset] : 0u;                      \n"
+    "        barrier();                                                             \n"
+    "        s_Scan[t] += add;                                                      \n"
+    "        barrier();                                                             \n"
+    "    }                                                                          \n"
+    "    total = s_Scan[THREADS - 1u];                                              \n"
+    "    uint result = s_Scan[t] - value;                                           \n"
+    "    barrier();                                                                 \n"
+    "    return result;                                                             \n"
+    "}                                                                              \n";
+
+constexpr std::string_view scanShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer Input { uint inData[]; };          \n"
+    "layout(std430, binding = 1) writeonly buffer Output { uint outData[]; };       \n"
+    "layout(std430, binding = 2) writeonly buffer Sums { uint sums[]; };            \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_InOffset, u_OutOffset;                                 \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint block = groupIndex();                                                 \n"
+    "    if (block * BLOCK >= u_Count) { return; }                                  \n"
+    "                                                                               \n"
+    "    uint base = block * BLOCK + gl_LocalInvocationID.x * PER_THREAD;           \n"
+    "    uint values[PER_THREAD];                                                   \n"
+    "    uint sum = 0u;                                                             \n"
+    "    for (uint k = 0u; k < PER_THREAD; k++) {                                   \n"
+    "        values[k] = base + k < u_Count ? inData[u_InOffset + base + k] : 0u;   \n"
+    "#ifdef PREDICATE                                                               \n"
+    "        values[k] = values[k] != 0u ? 1u : 0u;                                 \n"
+    "#endif                                                                         \n"
+    "        sum += values[k];                                                      \n"
+    "    }                                                                          \n"
+    "                                                                               \n"
+    "    uint total;                                                                \n"
+    "    uint prefix = groupExclusiveScan(sum, total);                              \n"
+    "    for (uint k = 0u; k < PER_THREAD && base + k < u_Count; k++) {             \n"
+    "        outData[u_OutOffset + base + k] = prefix;                              \n"
+    "        prefix += values[k];                                                   \n"
+    "    }                                                                          \n"
+    "    if (gl_LocalInvocationID.x == 0u) { sums[block] = total; }                 \n"
+    "}                                                                              \n";
+
+constexpr std::string_view addOffsetsShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 1) buffer Output { uint outData[]; };                 \n"
+    "layout(std430, binding = 2) readonly buffer Sums { uint sums[]; };             \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_OutOffset;                                             \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint block = groupIndex();                                                 \n"
+    "    if (block * BLOCK >= u_Count) { return; }                                  \n"
+    "                                                                               \n"
+    "    uint offset = sums[block];                                                 \n"
+    "    uint base = block * BLOCK + gl_LocalInvocationID.x * PER_THREAD;           \n"
+    "    for (uint k = 0u; k < PER_THREAD && base + k < u_Count; k++) {             \n"
+    "        outData[u_OutOffset + base + k] += offset;                             \n"
+    "    }                                                                          \n"
+    "}                                                                              \n";
+
+// Variants: TYPE, IDENTITY and OP(a, b) define the reduction
+constexpr std::string_view reduceShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer Input { TYPE inData[]; };          \n"
+    "layout(std430, binding = 1) writeonly buffer Output { TYPE outData[]; };       \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_InOffset, u_OutOffset;                                 \n"
+    "shared TYPE s_Reduce[THREADS];                                                 \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint block = groupIndex();                                                 \n"
+    "    if (block * BLOCK >= u_Count) { return; }                                  \n"
+    "                                                                               \n"
+    "    uint t = gl_LocalInvocationID.x;                                           \n"
+    "    uint base = block * BLOCK + t * PER_THREAD;                                \n"
+    "    TYPE value = IDENTITY;                                                     \n"
+    "    for (uint k = 0u; k < PER_THREAD && base + k < u_Count; k++) {             \n"
+    "        value = OP(value, inData[u_InOffset + base + k]);                      \n"
+    "    }                                                                          \n"
+    "                                                                               \n"
+    "    s_Reduce[t] = value;                                                       \n"
+    "    barrier();                                                                 \n"
+    "    for (uint stride = THREADS / 2u; stride > 0u; stride >>= 1u) {             \n"
+    "        if (t < stride) { s_Reduce[t] = OP(s_Reduce[t], s_Reduce[t + stride]); } \n"
+    "        barrier();                                                             \n"
+    "    }                                                                          \n"
+    "    if (t == 0u) { outData[u_OutOffset + block] = s_Reduce[0]; }               \n"
+    "}                                                                              \n";
+
+// Counts digits of every block. Histogram is digit major, so its scan gives global positions
+constexpr std::string_view histogramShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer Keys { uint keys[]; };             \n"
+    "layout(std430, binding = 4) writeonly buffer Histogram { uint histogram[]; };  \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_InOffset, u_Shift, u_NumBlocks;                        \n"
+    "shared uint s_Histogram[16];                                                   \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint block = groupIndex();                                                 \n"
+    "    if (block >= u_NumBlocks) { return; }                                      \n"
+    "                                                                               \n"
+    "    uint t = gl_LocalInvocationID.x;                                           \n"
+    "    if (t < 16u) { s_Histogram[t] = 0u; }                                      \n"
+    "    barrier();                                                                 \n"
+    "                                                                               \n"
+    "    uint base = block * BLOCK + t * PER_THREAD;                                \n"
+    "    for (uint k = 0u; k < PER_THREAD && base + k < u_Count; k++) {             \n"
+    "        atomicAdd(s_Histogram[(keys[u_InOffset + base + k] >> u_Shift) & 15u], 1u); \n"
+    "    }                                                                          \n"
+    "    barrier();                                                                 \n"
+    "    if (t < 16u) { histogram[t * u_NumBlocks + block] = s_Histogram[t]; }      \n"
+    "}                                                                              \n";
+
+// Variants: VALUES moves values along with keys
+constexpr std::string_view scatterShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer KeysIn { uint keysIn[]; };         \n"
+    "layout(std430, binding = 2) writeonly buffer KeysOut { uint keysOut[]; };      \n"
+    "layout(std430, binding = 4) readonly buffer Histogram { uint histogram[]; };   \n"
+    "#ifdef VALUES                                                                  \n"
+    "layout(std430, binding = 1) readonly buffer ValuesIn { uint valuesIn[]; };     \n"
+    "layout(std430, binding = 3) writeonly buffer ValuesOut { uint valuesOut[]; };  \n"
+    "#endif                                                                         \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_InOffset, u_OutOffset, u_Shift, u_NumBlocks;           \n"
+    "uniform uint u_ValueInOffset, u_ValueOutOffset;                                \n"
+    "shared uint s_Counts[16u * THREADS]; // digit major                            \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint block = groupIndex();                                                 \n"
+    "    if (block >= u_NumBlocks) { return; }                                      \n"
+    "                                                                               \n"
+    "    uint t = gl_LocalInvocationID.x;                                           \n"
+    "    uint base = block * BLOCK + t * PER_THREAD;                                \n"
+    "    for (uint d = 0u; d < 16u; d++) { s_Counts[d * THREADS + t] = 0u; }        \n"
+    "                                                                               \n"
+    "    uint keys[PER_THREAD], digits[PER_THREAD];                                 \n"
+    "    for (uint k = 0u; k < PER_THREAD; k++) {                                   \n"
+    "        digits[k] = 16u; // out of range                                       \n"
+    "        if (base + k < u_Count) {                                              \n"
+    "            keys[k] = keysIn[u_InOffset + base + k];                           \n"
+    "            digits[k] = (keys[k] >> u_Shift) & 15u;                            \n"
+    "            s_Counts[digits[k] * THREADS + t]++;                               \n"
+    "        }                                                                      \n"
+    "    }                                                                          \n"
+    "    barrier();                                                                 \n"
+    "                                                                               \n"
+    "    // Block wide exclusive scan of all counters, sixteen per thread           \n"
+    "    uint sum = 0u;                                                             \n"
+    "    for (uint j = 0u; j < 16u; j++) {                                          \n"
+    "        uint count = s_Counts[16u * t + j];                                    \n"
+    "        s_Counts[16u * t + j] = sum;                                           \n"
+    "        sum += count;                                                          \n"
+    "    }                                                                          \n"
+    "    uint total;                                                                \n"
+    "    uint prefix = groupExclusiveScan(sum, total);                              \n"
+    "    for (uint j = 0u; j < 16u; j++) { s_Counts[16u * t + j] += prefix; }       \n"
+    "    barrier();                                                                 \n"
+    "                                                                               \n"
+    "    for (uint k = 0u; k < PER_THREAD; k++) {                                   \n"
+    "        uint d = digits[k];                                                    \n"
+    "        if (d >= 16u) { continue; }                                            \n"
+    "                                                                               \n"
+    "        // Rank among same digits in previous threads, then in this thread     \n"
+    "        uint rank = s_Counts[d * THREADS + t] - s_Counts[d * THREADS];         \n"
+    "        for (uint l = 0u; l < k; l++) { rank += digits[l] == d ? 1u : 0u; }    \n"
+    "                                                                               \n"
+    "        uint dst = histogram[d * u_NumBlocks + block] + rank;                  \n"
+    "        keysOut[u_OutOffset + dst] = keys[k];                                  \n"
+    "#ifdef VALUES                                                                  \n"
+    "        valuesOut[u_ValueOutOffset + dst] = valuesIn[u_ValueInOffset + base + k]; \n"
+    "#endif                                                                         \n"
+    "    }                                                                          \n"
+    "}                                                                              \n";
+
+constexpr std::string_view compactShader =
+    "#version 450 core                                                              \n"
+    "#include <GRender/gpu.glsl>                                                    \n"
+    "                                                                               \n"
+    "layout(std430, binding = 0) readonly buffer Input { uint inData[]; };          \n"
+    "layout(std430, binding = 1) readonly buffer Flags { uint flags[]; };           \n"
+    "layout(std430, binding = 2) readonly buffer Indices { uint indices[]; };       \n"
+    "layout(std430, binding = 3) writeonly buffer Output { uint outData[]; };       \n"
+    "layout(std430, binding = 4) writeonly buffer Counter { uint counter[]; };      \n"
+    "                                                                               \n"
+    "uniform uint u_Count, u_InOffset, u_FlagOffset, u_OutOffset, u_CounterIndex;   \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    uint base = groupIndex() * BLOCK + gl_LocalInvocationID.x * PER_THREAD;    \n"
+    "    for (uint k = 0u; k < PER_THREAD && base + k < u_Count; k++) {             \n"
+    "        uint i = base + k;                                                     \n"
+    "        bool keep = flags[u_FlagOffset + i] != 0u;                             \n"
+    "        if (keep) { outData[u_OutOffset + indices[i]] = inData[u_InOffset + i]; } \n"
+    "        if (i == u_Count - 1u) { counter[u_CounterIndex] = indices[i] + (keep ? 1u : 0u); } \n"
+    "    }                                                                          \n"
+    "}                                                                              \n";
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Temporary buffers are kept between calls and only grow
+enum Scratch : uint32_t {
+    SORT_KEYS,
+    SORT_VALUES,
+    SORT_HISTOGRAM,
+    COMPACT_INDICES,
+    REDUCE_PING,
+    REDUCE_PONG,
+    REDUCE_RESULT,
+    SCAN_LEVELS // one per level of recursion
+};
+
+static const StorageBuffer& scratch(uint32_t slot, size_t numElements) {
+    static std::unordered_map<uint32_t, StorageBuffer> buffers;
+
+    StorageBuffer& buffer = buffers[slot];
+    const size_t numBytes = std::max<size_t>(numElements, 1) * sizeof(uint32_t);
+    if (buffer.numBytes() < numBytes) { buffer = StorageBuffer(numBytes); }
+    return buffer;
+}
+
+static ComputeShader& kernel(const std::string& name, std::string_view code, const shader::Defines& defines = {}) {
+    static std::unordered_map<std::string, ComputeShader> kernels;
+
+    std::string key = name;
+    for (auto& [macro, value] : defines) { key += ";" + macro + "=" + value; }
+
+    auto it = kernels.find(key);
+    if (it == kernels.end()) {
+        shader::RegisterInclude("GRender/gpu.glsl", std::string(commonCode));
+        it = kernels.emplace(key, ComputeShader(shader::Source{ code, name }, defines)).first;
+    }
+
+    it->second.bind();
+    return it->second;
+}
+
+static uint32_t elementIndex(const Range& range) {
+    ASSERT(range.offset % sizeof(uint32_t) == 0, "Offsets must be multiple of 4 bytes!!");
+    return static_cast<uint32_t>(range.offset / sizeof(uint32_t));
+}
+
+static uint32_t numBlocks(size_t count) {
+    return static_cast<uint32_t>((count + BLOCK - 1) / BLOCK);
+}
+
+static void dispatchBlocks(const ComputeShader& shader, uint32_t numBlocks) {
+    const uint32_t x = std::min(numBlocks, MAX_GROUPS_X);
+    shader.dispatch(x, (numBlocks + x - 1) / x);
+}
+
+static void checkRange(const Range& range, size_t count) {
+    ASSERT(range.buffer && *range.buffer, "StorageBuffer not initialized!!");
+    ASSERT(range.offset + count * sizeof(uint32_t) <= range.buffer->numBytes(), "Range exceeds buffer size!!");
+    ASSERT(count < std::numeric_limits<uint32_t>::max(), "Too many elements!!");
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// Predicate scans non-zero flags as ones, only needed on the first level
+static void scanLevel(const Range& input, const Range& output, size_t count, uint32_t level, bool predicate = false) {
+    const uint32_t blocks = numBlocks(count);
+    const StorageBuffer& sums = scratch(SCAN_LEVELS + level, blocks);
+
+    ComputeShader& scan = predicate ? kernel("scan.comp", scanShader, { { "PREDICATE", "" } })
+                                    : kernel("scan.comp", scanShader);
+    scan.setUniform("u_Count", static_cast<uint32_t>(count));
+    scan.setUniform("u_InOffset", elementIndex(input));
+    scan.setUniform("u_OutOffset", elementIndex(output));
+    scan.setBuffer(*input.buffer, 0, shader::Access::READ_ONLY);
+    scan.setBuffer(*output.buffer, 1, shader::Access::WRITE_ONLY);
+    scan.setBuffer(sums, 2, shader::Access::WRITE_ONLY);
+    dispatchBlocks(scan, blocks);
+
+    if (blocks == 1) { return; }
+
+    // Offsets of every block come from scanning their sums
+    scanLevel(sums, sums, blocks, level + 1);
+
+    ComputeShader& add = kernel("addOffsets.comp", addOffsetsShader);
+    add.setUniform("u_Count", static_cast<uint32_t>(count));
+    add.setUniform("u_OutOffset", elementIndex(output));
+    add.setBuffer(*output.buffer, 1, shader::Access::READ_WRITE);
+    add.setBuffer(sums, 2, shader::Access::READ_ONLY);
+    dispatchBlocks(add, blocks);
+}
+
+void exclusiveScan(Range input, Range output, size_t count) {
+    if (count == 0) { return; }
+    checkRange(input, count);
+    checkRange(output, count);
+    scanLevel(input, output, count, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static shader::Defines reduceDefines(Operation op, Type type) {
+    shader::Defines defines;
+    switch (type) {
+    case Type::INT:
+        defines["TYPE"] = "int";
+        defines["IDENTITY"] = op == Operation::SUM ? "0" : (op == Operation::MIN ? "2147483647" : "(-2147483647 - 1)");
+        break;
+    case Type::FLOAT:
+        defines["TYPE"] = "float";
+        defines["IDENTITY"] = op == Operation::SUM ? "0.0" : (op == Operation::MIN ? "uintBitsToFloat(0x7F800000u)" : "uintBitsToFloat(0xFF800000u)");
+        break;
+    default:
+        defines["TYPE"] = "uint";
+        defines["IDENTITY"] = op == Operation::SUM ? "0u" : (op == Operation::MIN ? "0xFFFFFFFFu" : "0u");
+        break;
+    }
+
+    switch (op) {
+    case Operation::MIN: defines["OP(a, b)"] = "min(a, b)"; break;
+    case Operation::MAX: defines["OP(a, b)"] = "max(a, b)"; break;
+    default:             defines["OP(a, b)"] = "((a) + (b))"; break;
+    }
+    return defines;
+}
+
+void reduce(Range input, size_t count, Range result, Operation op, Type type) {
+    ASSERT(count > 0, "Cannot reduce empty range!!");
+    checkRange(input, count);
+    checkRange(result, 1);
+
+    ComputeShader& shader = kernel("reduce.comp", reduceShader, reduceDefines(op, type));
+
+    // Every pass reduces blocks into partial results, until a single one is left
+    Range current = input;
+    uint32_t ping = REDUCE_PING;
+    do {
+        const uint32_t blocks = numBlocks(count);
+        const Range output = blocks == 1 ? result : Range(scratch(ping, blocks));
+
+        shader.setUniform("u_Count", static_cast<uint32_t>(count));
+        shader.setUniform("u_InOffset", elementIndex(current));
+        shader.setUniform("u_OutOffset", elementIndex(output));
+        shader.setBuffer(*current.buffer, 0, shader::Access::READ_ONLY);
+        shader.setBuffer(*output.buffer, 1, shader::Access::WRITE_ONLY);
+        dispatchBlocks(shader, blocks);
+
+        current = output;
+        count = blocks;
+        ping = ping == REDUCE_PING ? REDUCE_PONG : REDUCE_PING;
+    } while (count > 1);
+}
+
+template <typename TP>
+static constexpr Type typeOf(void) {
+    if constexpr (std::is_same_v<TP, float>) { return Type::FLOAT; }
+    else if constexpr (std::is_same_v<TP, int32_t>) { return Type::INT; }
+    else { return Type::UINT; }
+}
+
+template <typename TP>
+TP reduce(Range input, size_t count, Operation op) {
+    const StorageBuffer& result = scratch(REDUCE_RESULT, 1);
+    reduce(input, count, result, op, typeOf<TP>());
+    return result.getBuffer<TP>(0, 1).front();
+}
+
+template uint32_t reduce<uint32_t>(Range, size_t, Operation);
+template int32_t reduce<int32_t>(Range, size_t, Operation);
+template float reduce<float>(Range, size_t, Operation);
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+static void radixSort(const Range& keys, const Range* values, size_t count) {
+    if (count == 0) { return; }
+    checkRange(keys, count);
+    if (values) { checkRange(*values, count); }
+
+    const uint32_t blocks = numBlocks(count);
+    const StorageBuffer& histogram = scratch(SORT_HISTOGRAM, RADIX * size_t(blocks));
+    const Range tmpKeys(scratch(SORT_KEYS, count));
+    const Range tmpValues(scratch(values ? SORT_VALUES : SORT_KEYS, values ? count : 1));
+
+    // Even number of passes, so results end up back in the input ranges
+    for (uint32_t shift = 0; shift < 32; shift += RADIX_BITS) {
+        const bool even = (shift / RADIX_BITS) % 2 == 0;
+        const Range& srcKeys = even ? keys : tmpKeys;
+        const Range& dstKeys = even ? tmpKeys : keys;
+
+        ComputeShader& hist = kernel("radixHistogram.comp", histogramShader);
+        hist.setUniform("u_Count", static_cast<uint32_t>(count));
+        hist.setUniform("u_InOffset", elementIndex(srcKeys));
+        hist.setUniform("u_Shift", shift);
+        hist.setUniform("u_NumBlocks", blocks);
+        hist.setBuffer(*srcKeys.buffer, 0, shader::Access::READ_ONLY);
+        hist.setBuffer(histogram, 4, shader::Access::WRITE_ONLY);
+        dispatchBlocks(hist, blocks);
+
+        exclusiveScan(histogram, histogram, RADIX * size_t(blocks));
+
+        ComputeShader& scatter = values ? kernel("radixScatter.comp", scatterShader, { { "VALUES", "" } })
+                                        : kernel("radixScatter.comp", scatterShader);
+        scatter.setUniform("u_Count", static_cast<uint32_t>(count));
+        scatter.setUniform("u_InOffset", elementIndex(srcKeys));
+        scatter.setUniform("u_OutOffset", elementIndex(dstKeys));
+        scatter.setUniform("u_Shift", shift);
+        scatter.setUniform("u_NumBlocks", blocks);
+        scatter.setBuffer(*srcKeys.buffer, 0, shader::Access::READ_ONLY);
+        scatter.setBuffer(*dstKeys.buffer, 2, shader::Access::WRITE_ONLY);
+        scatter.setBuffer(histogram, 4, shader::Access::READ_ONLY);
+        if (values) {
+            const Range& srcValues = even ? *values : tmpValues;
+            const Range& dstValues = even ? tmpValues : *values;
+            scatter.setUniform("u_ValueInOffset", elementIndex(srcValues));
+            scatter.setUniform("u_ValueOutOffset", elementIndex(dstValues));
+            scatter.setBuffer(*srcValues.buffer, 1, shader::Access::READ_ONLY);
+            scatter.setBuffer(*dstValues.buffer, 3, shader::Access::WRITE_ONLY);
+        }
+        dispatchBlocks(scatter, blocks);
+    }
+}
+
+void radixSortKeysValues(Range keys, Range values, size_t count) {
+    radixSort(keys, &values, count);
+}
+
+void radixSortKeys(Range keys, size_t count) {
+    radixSort(keys, nullptr, count);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+void compact(Range input, Range flags, Range output, size_t count, Range counter) {
+    checkRange(input, count);
+    checkRange(flags, count);
+    checkRange(output, count);
+    checkRange(counter, 1);
+
+    if (count == 0) {
+        const uint32_t zero = 0;
+        gl::Consume(gl::Resource::BUFFER, counter.buffer->id(), GL_BUFFER_UPDATE_BARRIER_BIT);
+        glClearNamedBufferSubData(counter.buffer->id(), GL_R32UI, counter.offset, sizeof(uint32_t), GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+        return;
+    }
+
+    // Destination of every kept element, any non-zero flag counts as one
+    const StorageBuffer& indices = scratch(COMPACT_INDICES, count);
+    scanLevel(flags, indices, count, 0, true);
+
+    ComputeShader& shader = kernel("compact.comp", compactShader);
+    shader.setUniform("u_Count", static_cast<uint32_t>(count));
+    shader.setUniform("u_InOffset", elementIndex(input));
+    shader.setUniform("u_FlagOffset", elementIndex(flags));
+    shader.setUniform("u_OutOffset", elementIndex(output));
+    shader.setUniform("u_CounterIndex", elementIndex(counter));
+    shader.setBuffer(*input.buffer, 0, shader::Access::READ_ONLY);
+    shader.setBuffer(*flags.buffer, 1, shader::Access::READ_ONLY);
+    shader.setBuffer(indices, 2, shader::Access::READ_ONLY);
+    shader.setBuffer(*output.buffer, 3, shader::Access::WRITE_ONLY);
+    shader.setBuffer(*counter.buffer, 4, shader::Access::WRITE_ONLY);
+    dispatchBlocks(shader, numBlocks(count));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+namespace cpu {
+
+std::vector<uint32_t> exclusiveScan(const std::vector<uint32_t>& input) {
+    std::vector<uint32_t> output(input.size());
+    uint32_t sum = 0;
+    for (size_t k = 0; k < input.size(); k++) {
+        output[k] = sum;
+        sum += input[k];
+    }
+    return output;
+}
+
+template <typename TP>
+TP reduce(const std::vector<TP>& input, Operation op) {
+    switch (op) {
+    case Operation::MIN: return input.empty() ? std::numeric_limits<TP>::max() : *std::min_element(input.begin(), input.end());
+    case Operation::MAX: return input.empty() ? std::numeric_limits<TP>::lowest() : *std::max_element(input.begin(), input.end());
+    default:             return std::accumulate(input.begin(), input.end(), TP(0));
+    }
+}
+
+template uint32_t reduce<uint32_t>(const std::vector<uint32_t>&, Operation);
+template int32_t reduce<int32_t>(const std::vector<int32_t>&, Operation);
+template float reduce<float>(const std::vector<float>&, Operation);
+
+void radixSortKeysValues(std::vector<uint32_t>& keys, std::vector<uint32_t>& values) {
+    ASSERT(keys.size() == values.size(), "Keys and values must have the same size!!");
+
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+    std::vector<uint32_t> sortedKeys(keys.size()), sortedValues(values.size());
+    for (size_t k = 0; k < order.size(); k++) {
+        sortedKeys[k] = keys[order[k]];
+        sortedValues[k] = values[order[k]];
+    }
+    keys.swap(sortedKeys);
+    values.swap(sortedValues);
+}
+
+std::vector<uint32_t> compact(const std::vector<uint32_t>& input, const std::vector<uint32_t>& flags) {
+    std::vector<uint32_t> output;
+    for (size_t k = 0; k < input.size(); k++) {
+        if (flags[k] != 0) { output.push_back(input[k]); }
+    }
+    return output;
+}
+
+} // namespace cpu
+
+} // namespace GRender::gpu
@@ -4,24 +4,36 @@
 #include "events.h"
 #include "interactiveImage.h"
 #include "texture.h"
+#include "textureLoader.h"
 
 namespace GRender {
 
-InteractiveImage::InteractiveImage(const glm::uvec2& size, const texture::Specification& spec, const void* data) 
-    : m_Texture(size, spec, data) {
-
+static glm::vec2 portSize(const glm::uvec2& size) {
     const float ratio = static_cast<float>(size.x) / static_cast<float>(size.y);
-    m_Port = (size.x > size.y) ? glm::vec2{ 1024.0f, 1024.0f / ratio} : glm::vec2{ ratio * 728.0f, 728.0f};
+    return (size.x > size.y) ? glm::vec2{ 1024.0f, 1024.0f / ratio } : glm::vec2{ ratio * 728.0f, 728.0f };
 }
 
-InteractiveImage::InteractiveImage(const fs::path& filepath) 
-    : m_Texture(utils::createTextureFromRGBAFile(filepath)) {
-    
-    const glm::uvec2& size = m_Texture.size();
-    const float ratio = static_cast<float>(size.x) / static_cast<float>(size.y);
-    m_Port = (size.x > size.y) ? glm::vec2{ 1024.0f, 1024.0f / ratio } : glm::vec2{ ratio * 728.0f, 728.0f };
+InteractiveImage::InteractiveImage(const glm::uvec2& size, const texture::Specification& spec, const void* data) 
+    : m_Port(portSize(size)), m_Texture(std::make_shared<Texture>(size, spec, data)) {}
+
+// Photos are usually larger than the port, so trilinear filtering avoids aliasing when zoomed out
+static texture::Specification photoSpecification(void) {
+    texture::Specification spec;
+    spec.levels = 0;
+    spec.filter.min = texture::Filter::LINEAR;
+    spec.filter.mipmap = texture::Filter::LINEAR;
+    return spec;
 }
 
+InteractiveImage::InteractiveImage(const fs::path& filepath) 
+    : InteractiveImage(std::make_shared<Texture>(utils::createTextureFromRGBAFile(filepath, photoSpecification()))) {}
+
+InteractiveImage::InteractiveImage(const fs::path& filepath, TextureLoader& loader)
+    : InteractiveImage(loader.load(filepath, photoSpecification())) {}
+
+InteractiveImage::InteractiveImage(std::shared_ptr<Texture> texture)
+    : m_Port(portSize(texture->size())), m_Texture(std::move(texture)) {}
+
 InteractiveImage::InteractiveImage(InteractiveImage&& other) noexcept {
     // Simply copying small variables
     m_View = other.m_View;
@@ -47,7 +59,7 @@ InteractiveImage& InteractiveImage::operator=(InteractiveImage && other) noexcep
 void InteractiveImage::display(const std::string& windowName) {
     if (!m_View) { return; }
 
-    const glm::uvec2& texSize = m_Texture.size();
+    const glm::uvec2& texSize = m_Texture->size();
     const float ratio = static_cast<float>(texSize.x) / static_cast<float>(texSize.y);
     
     const float titlebarHeight = ImGui::GetFrameHeight();
@@ -125,7 +137,7 @@ void InteractiveImage::display(const std::string& windowName) {
 
 
     // Finally displaying image
-    ImGui::Image((void*)(uintptr_t)m_Texture.id(), { m_Port.x, m_Port.y }, {m_PosMin.x, m_PosMax.y}, {m_PosMax.x, m_PosMin.y});
+    ImGui::Image((void*)(uintptr_t)m_Texture->id(), { m_Port.x, m_Port.y }, {m_PosMin.x, m_PosMax.y}, {m_PosMax.x, m_PosMin.y});
     ImGui::End();
 
     // Removing styles used in this window
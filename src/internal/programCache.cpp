@@ -0,0 +1,126 @@
+#include <iomanip>
+
+#include "programCache.h"
+
+namespace GRender::shader::internal {
+
+// Binary files start with this tag followed by the binary format
+constexpr uint32_t MAGIC = 0x42505247; // "GRPB"
+
+// 64 bits FNV-1a, stable between runs and platforms
+static uint64_t fnv1a(const void* data, size_t numBytes, uint64_t hash = 0xcbf29ce484222325ull) {
+    const uint8_t* ptr = static_cast<const uint8_t*>(data);
+    for (size_t k = 0; k < numBytes; k++) {
+        hash ^= ptr[k];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+ProgramCache* ProgramCache::Instance() {
+    static ProgramCache cache;
+    return &cache;
+}
+
+void ProgramCache::enable(const fs::path& directory) {
+    GLint numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+    if (numFormats == 0) {
+        WARN("Driver doesn't support program binaries. Program cache is disabled");
+        return;
+    }
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        WARN("Cannot create program cache directory => " + directory.string());
+        return;
+    }
+
+    auto str = [](GLenum name) -> std::string {
+        const GLubyte* ptr = glGetString(name);
+        return ptr ? reinterpret_cast<const char*>(ptr) : "";
+    };
+
+    m_Driver = str(GL_VENDOR) + "\n" + str(GL_RENDERER) + "\n" + str(GL_VERSION);
+    m_Directory = directory;
+    m_Enabled = true;
+}
+
+void ProgramCache::disable(void) {
+    m_Enabled = false;
+}
+
+uint64_t ProgramCache::hash(const std::vector<Stage>& stages) const {
+    uint64_t key = fnv1a(m_Driver.data(), m_Driver.size());
+    for (const Stage& stage : stages) {
+        key = fnv1a(&stage.type, sizeof(stage.type), key);
+        key = fnv1a(stage.source.code.data(), stage.source.code.size(), key);
+    }
+    return key;
+}
+
+fs::path ProgramCache::filepath(uint64_t key) const {
+    std::stringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return m_Directory / name.str();
+}
+
+uint32_t ProgramCache::load(uint64_t key) const {
+    std::ifstream arq(filepath(key), std::ios::binary);
+    if (!arq) { return 0; }
+
+    uint32_t magic = 0, format = 0;
+    arq.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    arq.read(reinterpret_cast<char*>(&format), sizeof(format));
+    if (!arq || magic != MAGIC) { return 0; }
+
+    std::vector<char> binary{ std::istreambuf_iterator<char>(arq), std::istreambuf_iterator<char>() };
+    if (binary.empty()) { return 0; }
+
+    uint32_t programID = glCreateProgram();
+    glProgramBinary(programID, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // Driver updates or different hardware may reject the binary
+    int success = 0;
+    glGetProgramiv(programID, GL_LINK_STATUS, &success);
+    if (success == GL_FALSE) {
+        glDeleteProgram(programID);
+        return 0;
+    }
+
+    return programID;
+}
+
+void ProgramCache::save(uint64_t key, uint32_t programID) const {
+    GLint length = 0;
+    glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) { return; }
+
+    GLenum format = GL_NONE;
+    std::vector<char> binary(length);
+    glGetProgramBinary(programID, length, nullptr, &format, binary.data());
+
+    // We write into a temporary file first, so other instances never read half a binary
+    const fs::path path = filepath(key);
+    fs::path tmpPath = path;
+    tmpPath += ".tmp";
+
+    {
+        std::ofstream arq(tmpPath, std::ios::binary);
+        const uint32_t fmt = static_cast<uint32_t>(format);
+        arq.write(reinterpret_cast<const char*>(&MAGIC), sizeof(MAGIC));
+        arq.write(reinterpret_cast<const char*>(&fmt), sizeof(fmt));
+        arq.write(binary.data(), binary.size());
+        if (!arq) {
+            WARN("Cannot write program binary => " + tmpPath.string());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+    if (ec) { fs::remove(tmpPath, ec); }
+}
+
+} // namespace GRender::shader::internal
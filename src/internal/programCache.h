@@ -0,0 +1,39 @@
+#pragma once
+
+#include "core.h"
+#include "shaderUtils.h"
+
+namespace GRender::shader::internal {
+
+// Stores linked programs as driver binaries, so next launches can skip GLSL compilation.
+// Binaries are keyed by a hash of all the sources and the vendor, renderer and version strings.
+class ProgramCache {
+public:
+    static ProgramCache* Instance();
+
+    ProgramCache(const ProgramCache&) = delete;
+    ProgramCache& operator=(const ProgramCache&) = delete;
+
+    void enable(const fs::path& directory);
+    void disable(void);
+    bool enabled(void) const { return m_Enabled; }
+
+    uint64_t hash(const std::vector<Stage>& stages) const;
+
+    // Returns a linked program or zero if binary is not available or was rejected by the driver
+    uint32_t load(uint64_t key) const;
+    void save(uint64_t key, uint32_t programID) const;
+
+private:
+    ProgramCache(void) = default;
+    ~ProgramCache(void) = default;
+
+    fs::path filepath(uint64_t key) const;
+
+private:
+    bool m_Enabled = false;
+    fs::path m_Directory;
+    std::string m_Driver;  // vendor, renderer and version strings
+};
+
+} // namespace GRender::shader::internal
@@ -0,0 +1,63 @@
+#include "material.h"
+
+namespace GRender {
+
+MaterialLibrary::MaterialLibrary(const texture::Specification& spec, uint32_t layersPerArray)
+    : m_Spec(spec), m_LayersPerArray(layersPerArray) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    m_LayersPerArray = std::clamp(layersPerArray, 1u, uint32_t(maxLayers));
+}
+
+size_t MaterialLibrary::numMaterials(void) const {
+    size_t count = 0;
+    for (auto& entry : m_Arrays) { count += entry.used; }
+    return count;
+}
+
+material::Handle MaterialLibrary::allocate(const glm::uvec2& size, texture::Format fmt) {
+    // Newest array with room for same size and format, older ones are already full
+    auto it = std::find_if(m_Arrays.rbegin(), m_Arrays.rend(), [&](const Entry& entry) {
+        return entry.array.size() == size && entry.array.specification().fmt == fmt;
+    });
+
+    if (it == m_Arrays.rend() || it->used == it->array.numLayers()) {
+        texture::Specification spec = m_Spec;
+        spec.fmt = fmt;
+        m_Arrays.push_back({ TextureArray(size, m_LayersPerArray, spec) });
+        it = m_Arrays.rbegin();
+    }
+
+    return { &it->array, it->used++ };
+}
+
+TextureArray& MaterialLibrary::mutableArray(material::Handle handle) {
+    auto it = std::find_if(m_Arrays.begin(), m_Arrays.end(), [&](const Entry& entry) { return &entry.array == handle.array; });
+    ASSERT(it != m_Arrays.end(), "Material doesn't belong to this library!!");
+    return it->array;
+}
+
+material::Handle MaterialLibrary::add(const glm::uvec2& size, const void* data) {
+    material::Handle handle = allocate(size, m_Spec.fmt);
+    mutableArray(handle).update(handle.layer, data);
+    return handle;
+}
+
+material::Handle MaterialLibrary::add(const Texture& texture) {
+    ASSERT(texture, "Texture not initialized!!");
+
+    // No lookup by texture id, OpenGL hands ids of deleted textures to new ones
+    material::Handle handle = allocate(texture.size(), texture.specification().fmt);
+    mutableArray(handle).copy(handle.layer, texture);
+    return handle;
+}
+
+void MaterialLibrary::update(material::Handle handle, const void* data) {
+    mutableArray(handle).update(handle.layer, data);
+}
+
+void MaterialLibrary::update(material::Handle handle, const Texture& texture) {
+    mutableArray(handle).copy(handle.layer, texture);
+}
+
+} // namespace GRender
@@ -1,23 +1,37 @@
 
 
 #include "GRender/objects/object.h"
+#include "GRender/frame.h"
+#include "GRender/glState.h"
 
 namespace GRender {
 
+// Variants: PULLING reads instances from a storage buffer instead of vertex attributes
 constexpr std::string_view vertexShader =
     "#version 450 core                                 \n"
+    "#include <GRender/frame.glsl>                     \n"
+    "                                                  \n"
     "layout(location = 0) in vec3 vPosition;           \n"
     "layout(location = 1) in vec3 vNormal;             \n"
     "layout(location = 2) in vec2 vTexCoord;           \n"
+    "                                                  \n"
+    "#ifdef PULLING                                    \n"
+    "struct Instance {                                 \n"
+    "    vec3 position; int layer;                     \n"
+    "    vec3 rotation; float padding0;                \n"
+    "    vec3 scale;    float padding1;                \n"
+    "    vec4 color;                                   \n"
+    "};                                                \n"
+    "layout(std430, binding = INSTANCE_BINDING) readonly buffer Instances { Instance instances[]; }; \n"
+    "#else                                             \n"
     "layout(location = 3) in vec3 bPosition;           \n"
     "layout(location = 4) in vec3 bRotate;             \n"
     "layout(location = 5) in vec3 bScale;              \n"
     "layout(location = 6) in vec4 bColor;              \n"
-    "layout(location = 7) in int bTexID;               \n"
+    "layout(location = 7) in int bLayer;               \n"
+    "#endif                                            \n"
     "                                                  \n"
-    "uniform mat4 u_transform;                         \n"
-    "                                                  \n"
-    "out flat int  fTexID;                             \n"
+    "out flat int  fLayer;                             \n"
     "out vec2 fTexCoord;                               \n"
     "out vec4 fColor;                                  \n"
     "out vec3 fNormal;                                 \n"
@@ -30,10 +44,18 @@ constexpr std::string_view vertexShader =
     "}                                                 \n"
     "                                                  \n"
     "void main() {                                     \n"
+    "#ifdef PULLING                                    \n"
+    "    Instance inst = instances[gl_InstanceID];     \n"
+    "    vec3 bPosition = inst.position;               \n"
+    "    vec3 bRotate = inst.rotation;                 \n"
+    "    vec3 bScale = inst.scale;                     \n"
+    "    vec4 bColor = inst.color;                     \n"
+    "    int bLayer = inst.layer;                      \n"
+    "#endif                                            \n"
     "    mat2 rot;                                     \n"
     "                                                  \n"
     "    // Setup color and texture                    \n"
-    "    fTexID = bTexID;                              \n"
+    "    fLayer = bLayer;                              \n"
     "    fTexCoord = vTexCoord;                        \n"
     "    fColor = bColor;                              \n"
     "                                                  \n"
@@ -59,12 +81,13 @@ constexpr std::string_view vertexShader =
     "    // Translating position                       \n"
     "    fPos += bPosition;                            \n"
     "                                                  \n"
-    "    gl_Position = u_transform * vec4(fPos, 1.0);  \n"
+    "    gl_Position = u_Frame.viewProjection * vec4(fPos, 1.0); \n"
     "}                                                 \n";
 
+// Variants: TEXTURED samples a texture, LAYERED a layer of a texture array, otherwise only colors are used
 constexpr std::string_view fragmentShader =
     "#version 450 core                                                              \n"
-    "in flat int fTexID;                                                            \n"
+    "in flat int fLayer;                                                            \n"
     "in vec2 fTexCoord;                                                             \n"
     "in vec4 fColor;                                                                \n"
     "in vec3 fNormal;                                                               \n"
@@ -72,7 +95,11 @@ constexpr std::string_view fragmentShader =
     "                                                                               \n"
     "layout(location = 0) out vec4 fragColor;                                       \n"
     "                                                                               \n"
-    "uniform sampler2D texSampler[32];                                              \n"
+    "#if defined(TEXTURED)                                                          \n"
+    "uniform sampler2D texSampler;                                                  \n"
+    "#elif defined(LAYERED)                                                         \n"
+    "uniform sampler2DArray texSampler;                                             \n"
+    "#endif                                                                         \n"
     "                                                                               \n"
     "void main() {                                                                  \n"
     "    vec3 lightPos = vec3(0.0,100.0,50.0);                                      \n"
@@ -83,13 +110,17 @@ constexpr std::string_view fragmentShader =
     "                                                                               \n"
     "                                                                               \n"
     "    vec3 color = fColor.rgb;                                                   \n"
-    "	if (fTexID >= 0) { color *= texture(texSampler[fTexID], fTexCoord).rgb; }   \n"
+    "#if defined(TEXTURED)                                                          \n"
+    "    color *= texture(texSampler, fTexCoord).rgb;                               \n"
+    "#elif defined(LAYERED)                                                         \n"
+    "    if (fLayer >= 0) { color *= texture(texSampler, vec3(fTexCoord, fLayer)).rgb; } \n"
+    "#endif                                                                         \n"
     "                                                                               \n"
     "    color *= (ambientLight + diffuse);                                         \n"
     "    fragColor = vec4(color, 1.0);                                              \n"
     "}                                                                              \n";
 
-std::unique_ptr<Shader> Object::m_Shader = nullptr;
+std::unique_ptr<ShaderVariants> Object::m_Shader = nullptr;
 
 /// OBJECT IMPLEMENTATION ///////////////////////////////////////////////////////////////
 
@@ -101,50 +132,40 @@ Object::Object(uint32_t maxNumber) : m_MaxNumber(maxNumber) {
     m_Rotation.reserve(maxNumber);
     m_Scale.reserve(maxNumber);
     m_Color.reserve(maxNumber);
-    m_Texture.reserve(maxNumber);
+    m_Layer.reserve(maxNumber);
 
     // We need to initialize the shader the first time Object is created
     if (m_Shader == nullptr) {
-        const fs::path vtxPath = fs::temp_directory_path() / std::to_string(std::random_device()());
-        const fs::path fragPath = fs::temp_directory_path() / std::to_string(std::random_device()());
-
-        auto saveFile = [](const fs::path& filePath, const std::string_view& data) { std::ofstream(filePath) << data; };
-        saveFile(vtxPath, vertexShader);
-        saveFile(fragPath, fragmentShader);
-
-        m_Shader = std::make_unique<Shader>(vtxPath, fragPath);
-        fs::remove(vtxPath);
-        fs::remove(fragPath);
+        m_Shader = std::make_unique<ShaderVariants>(shader::Source{ vertexShader, "object.vert" },
+                                                    shader::Source{ fragmentShader, "object.frag" });
     }
 }
 
 Object::~Object(void) {
     if (m_VAO == 0) { return; } // nothing to do
 
-    glDeleteBuffers(1, &m_VTX);
-    glDeleteBuffers(1, &m_IDX);
-    glDeleteBuffers(1, &m_POS);
-    glDeleteBuffers(1, &m_ROT);
-    glDeleteBuffers(1, &m_SCL);
-    glDeleteBuffers(1, &m_CLR);
-    glDeleteBuffers(1, &m_TEX);
-    
-    glDeleteVertexArrays(1, &m_VAO);
+    for (uint32_t buffer : { m_VTX, m_IDX, m_POS, m_ROT, m_SCL, m_CLR, m_TEX }) {
+        gl::DeleteBuffer(buffer);
+    }
+    gl::DeleteVertexArray(m_VAO);
+    gl::DeleteVertexArray(m_PullVAO);
 
     m_MaxNumber = 0;
-    m_VTX = m_IDX = m_VAO = 0;
+    m_VTX = m_IDX = m_VAO = m_PullVAO = 0;
     m_POS = m_ROT = m_SCL = m_CLR = m_TEX = 0;
 
     m_Position.clear();
     m_Rotation.clear();
     m_Scale.clear();
     m_Color.clear();
-    m_Texture.clear();
+    m_Layer.clear();
+    m_Batches.clear();
 }
 
 Object::Object(Object&& obj) noexcept {
     std::swap(m_MaxNumber, obj.m_MaxNumber);
     std::swap(m_VAO, obj.m_VAO);
+    std::swap(m_PullVAO, obj.m_PullVAO);
     std::swap(m_VTX, obj.m_VTX);
     std::swap(m_IDX, obj.m_IDX);
     std::swap(m_POS, obj.m_POS);
@@ -153,6 +174,13 @@ Object::Object(Object&& obj) noexcept {
     std::swap(m_CLR, obj.m_CLR);
     std::swap(m_TEX, obj.m_TEX);
     std::swap(m_NumIndices, obj.m_NumIndices);
+
+    std::swap(m_Position, obj.m_Position);
+    std::swap(m_Rotation, obj.m_Rotation);
+    std::swap(m_Scale, obj.m_Scale);
+    std::swap(m_Color, obj.m_Color);
+    std::swap(m_Layer, obj.m_Layer);
+    std::swap(m_Batches, obj.m_Batches);
 }
 
 Object& Object::operator=(Object&& obj) noexcept {
@@ -168,10 +196,10 @@ void Object::initialize(const std::vector<Vertex>& vtxBuffer, const std::vector<
     m_NumIndices = static_cast<GLsizei>(3 * idxBuffer.size());
 
     glGenVertexArrays(1, &m_VAO);
-    glBindVertexArray(m_VAO);;
+    gl::BindVertexArray(m_VAO);
 
     glGenBuffers(1, &m_VTX);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VTX);
+    gl::BindBuffer(GL_ARRAY_BUFFER, m_VTX);
     glBufferData(GL_ARRAY_BUFFER, vtxBuffer.size() * sizeof(Vertex), vtxBuffer.data(), GL_DYNAMIC_DRAW);
 
     // layout for buffer
@@ -186,16 +214,18 @@ void Object::initialize(const std::vector<Vertex>& vtxBuffer, const std::vector<
     
     // setup index buffer
     glGenBuffers(1, &m_IDX);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IDX);
+    gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IDX);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, idxBuffer.size() * sizeof(glm::uvec3), idxBuffer.data(), GL_STATIC_DRAW);
  
     // INSTANCING ///////////////////////////////////////////////////////////////////////
     
     auto foo = [](uint32_t& bufID, uint32_t id, uint32_t size,  uint32_t maxNumber, size_t bytes) -> void {
         glGenBuffers(1, &bufID);
-        glBindBuffer(GL_ARRAY_BUFFER, bufID);
+        gl::BindBuffer(GL_ARRAY_BUFFER, bufID);
         glBufferData(GL_ARRAY_BUFFER, maxNumber * bytes, nullptr, GL_DYNAMIC_DRAW);
-        glVertexAttribPointer(id, size, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(bytes), nullptr);
+        // Integer attributes must skip float conversion
+        if (id == 7) { glVertexAttribIPointer(id, size, GL_INT, static_cast<GLsizei>(bytes), nullptr); }
+        else { glVertexAttribPointer(id, size, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(bytes), nullptr); }
         glEnableVertexAttribArray(id);
         glVertexAttribDivisor(id, 1);
     };
@@ -205,64 +235,116 @@ void Object::initialize(const std::vector<Vertex>& vtxBuffer, const std::vector<
     foo(m_SCL, 5, 3, m_MaxNumber, sizeof(glm::vec3));
     foo(m_CLR, 6, 4, m_MaxNumber, sizeof(glm::vec4));
     foo(m_TEX, 7, 1, m_MaxNumber, sizeof(int32_t));
-}
 
-void Object::draw(const glm::mat4& viewMatrix) {
-    // Preparing shader for rendering
-    m_Shader->bind();
-    m_Shader->setUniform("u_transform", viewMatrix);
+    // VERTEX PULLING ///////////////////////////////////////////////////////////////////
+    // Same mesh without instance attributes, so no fetches happen beyond m_MaxNumber
 
-    for (auto [tex, id] : m_TextureMap) {
-        m_Shader->setTexture(*tex, id);
-    }
+    glCreateVertexArrays(1, &m_PullVAO);
+    glVertexArrayVertexBuffer(m_PullVAO, 0, m_VTX, 0, sizeof(Vertex));
+    glVertexArrayElementBuffer(m_PullVAO, m_IDX);
 
-    // Binding buffer for drawing
-    glBindVertexArray(m_VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_VTX);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IDX);
-    // Submitting data into graphics card
-    const uint32_t numBodies = static_cast<uint32_t>(m_Position.size());
+    auto attribute = [&](uint32_t id, int32_t size, size_t offset) -> void {
+        glEnableVertexArrayAttrib(m_PullVAO, id);
+        glVertexArrayAttribFormat(m_PullVAO, id, size, GL_FLOAT, GL_FALSE, static_cast<uint32_t>(offset));
+        glVertexArrayAttribBinding(m_PullVAO, id, 0);
+    };
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_POS);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numBodies * sizeof(glm::vec3), m_Position.data());
-    
-    glBindBuffer(GL_ARRAY_BUFFER, m_ROT);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numBodies * sizeof(glm::vec3), m_Rotation.data());
+    attribute(0, 3, offsetof(Vertex, position));
+    attribute(1, 3, offsetof(Vertex, normal));
+    attribute(2, 2, offsetof(Vertex, texCoord));
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_SCL);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numBodies * sizeof(glm::vec3), m_Scale.data());
+void Object::draw(const glm::mat4& viewMatrix) {
+    frame::SetViewProjection(viewMatrix);
+    draw();
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_CLR);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numBodies * sizeof(glm::vec4), m_Color.data());
+void Object::draw(void) {
+    // Preparing shader for rendering
+    frame::Upload();
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_TEX);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, numBodies * sizeof(int32_t), m_Texture.data());
+    // Submitting data into graphics card, no binding required
+    const uint32_t numBodies = static_cast<uint32_t>(m_Position.size());
 
-    // Drawing all objects in one call
-    glDrawElementsInstanced(GL_TRIANGLES, m_NumIndices, GL_UNSIGNED_INT, nullptr, numBodies);
+    glNamedBufferSubData(m_POS, 0, numBodies * sizeof(glm::vec3), m_Position.data());
+    glNamedBufferSubData(m_ROT, 0, numBodies * sizeof(glm::vec3), m_Rotation.data());
+    glNamedBufferSubData(m_SCL, 0, numBodies * sizeof(glm::vec3), m_Scale.data());
+    glNamedBufferSubData(m_CLR, 0, numBodies * sizeof(glm::vec4), m_Color.data());
+    glNamedBufferSubData(m_TEX, 0, numBodies * sizeof(int32_t), m_Layer.data());
+
+    // Vertex and index buffers are part of the vertex array state
+    gl::BindVertexArray(m_VAO);
+
+    // One call per batch, each one with a single texture, so sampling is always uniform.
+    // Base instance offsets instanced attributes to the batch
+    for (const Batch& batch : m_Batches) {
+        if (batch.array) {
+            Shader& shader = m_Shader->get({ { "LAYERED", "" } });
+            shader.bind();
+            shader.setTexture(*batch.array);
+        }
+        else if (batch.texture) {
+            Shader& shader = m_Shader->get({ { "TEXTURED", "" } });
+            shader.bind();
+            shader.setTexture(*batch.texture);
+        }
+        else {
+            m_Shader->get().bind();
+        }
+
+        glDrawElementsInstancedBaseInstance(GL_TRIANGLES, m_NumIndices, GL_UNSIGNED_INT, nullptr, batch.count, batch.first);
+    }
 
     // Clearing up for next round
     m_Position.clear();
     m_Rotation.clear();
     m_Scale.clear();
     m_Color.clear();
-    m_Texture.clear();
-    m_TextureMap.clear();
+    m_Layer.clear();
+    m_Batches.clear();
+}
+
+void Object::drawFromBuffer(const StorageBuffer& instances, uint32_t count, const glm::mat4& viewMatrix,
+                            const TextureArray* materials) {
+    frame::SetViewProjection(viewMatrix);
+    drawFromBuffer(instances, count, materials);
+}
+
+void Object::drawFromBuffer(const StorageBuffer& instances, uint32_t count, const TextureArray* materials) {
+    ASSERT(m_NumIndices > 0, "Object was not initialized!");
+    ASSERT(instances, "StorageBuffer not initialized!!");
+    ASSERT(count * sizeof(object::Instance) <= instances.numBytes(), "Instance buffer is smaller than requested count!!");
+    if (count == 0) { return; }
+
+    frame::Upload();
+
+    shader::Defines defines = { { "PULLING", "" }, { "INSTANCE_BINDING", std::to_string(object::INSTANCE_BINDING) } };
+    if (materials) { defines["LAYERED"] = ""; }
+
+    Shader& shader = m_Shader->get(defines);
+    shader.bind();
+    if (materials) { shader.setTexture(*materials); }
+
+    // Waits for compute shaders still writing instances
+    instances.bind(object::INSTANCE_BINDING);
+
+    gl::BindVertexArray(m_PullVAO);
+    glDrawElementsInstanced(GL_TRIANGLES, m_NumIndices, GL_UNSIGNED_INT, nullptr, count);
 }
 
 void Object::submit(const Specification& specs) {
-    int32_t texId = -1;
-    if (specs.texture) {
-        auto it = m_TextureMap.emplace(specs.texture, static_cast<int32_t>(m_TextureMap.size()));
-        texId = it.first->second;
-        ASSERT(texId < 32, "Cannot use more than 32 textures at the same draw call");
+    // New batch whenever object samples something else than the previous one
+    const Texture* texture = specs.material ? nullptr : specs.texture;
+    if (m_Batches.empty() || m_Batches.back().texture != texture || m_Batches.back().array != specs.material.array) {
+        m_Batches.push_back({ texture, specs.material.array, static_cast<uint32_t>(m_Position.size()), 0 });
     }
+    m_Batches.back().count++;
 
     m_Position.push_back(specs.position);
     m_Rotation.push_back(specs.rotation);
     m_Scale.push_back(specs.scale);
     m_Color.push_back(specs.color);
-    m_Texture.push_back(texId);
+    m_Layer.push_back(specs.material ? static_cast<int32_t>(specs.material.layer) : -1);
     ASSERT(m_Position.size() <= m_MaxNumber, "More objects submitted than allocated :: " + std::to_string(m_Position.size()) + " > " + std::to_string(m_MaxNumber));
 }
 
@@ -88,10 +88,12 @@ void OrbitalCamera::display(void) {
     ImGui::End();
 }
 
-glm::mat4 OrbitalCamera::getViewMatrix(void) {
-    glm::mat4 proj = glm::perspective(m_FOV, m_Ratio, m_Near, m_Far);
-    glm::mat4 view = glm::lookAt(m_Distance * m_Front, m_Position, {0.0f, 1.0f, 0.0f });
-    return proj * view;
+glm::mat4 OrbitalCamera::getLookAtMatrix(void) {
+    return glm::lookAt(getEyePosition(), m_Position, {0.0f, 1.0f, 0.0f });
+}
+
+glm::vec3 OrbitalCamera::getEyePosition(void) {
+    return m_Distance * m_Front;
 }
 
 void OrbitalCamera::reset() {
@@ -1,46 +1,57 @@
 #include "quad.h"
+#include "frame.h"
+#include "glState.h"
 
 namespace GRender {
 using namespace quad;
 
 constexpr std::string_view vertexShader =
     "#version 450 core                                      \n"
+    "#include <GRender/frame.glsl>                          \n"
+    "                                                       \n"
     "layout(location = 0) in vec3 position;                 \n"
     "layout(location = 1) in vec4 color;                    \n"
     "layout(location = 2) in vec2 texCoord;                 \n"
-    "layout(location = 3) in int  texID;                    \n"
-    "                                                       \n"
-    "uniform mat4 u_transform;                              \n"
+    "layout(location = 3) in int  layer;                    \n"
     "                                                       \n"
     "out vec4 fColor;                                       \n"
     "out vec2 fTexCoord;                                    \n"
-    "out flat int fTexID;                                   \n"
+    "out flat int fLayer;                                   \n"
     "                                                       \n"
     "void main() {                                          \n"
     "    fColor = color;                                    \n"
     "    fTexCoord = texCoord;                              \n"
-    "    fTexID = texID;                                    \n"
-    "    gl_Position = u_transform * vec4(position, 1.0);   \n"
+    "    fLayer = layer;                                    \n"
+    "    gl_Position = u_Frame.viewProjection * vec4(position, 1.0); \n"
     "}                                                      \n";
 
+// Variants: TEXTURED samples a texture, LAYERED a layer of a texture array, otherwise only colors are used
 constexpr std::string_view fragmentShader =
     "#version 450 core                                                              \n"
     "                                                                               \n"
     "in vec4 fColor;                                                                \n"
     "in vec2 fTexCoord;                                                             \n"
-    "in flat int fTexID;                                                            \n"
+    "in flat int fLayer;                                                            \n"
     "                                                                               \n"
-    "uniform sampler2D texSampler[32];                                              \n"
+    "#if defined(TEXTURED)                                                          \n"
+    "uniform sampler2D texSampler;                                                  \n"
+    "#elif defined(LAYERED)                                                         \n"
+    "uniform sampler2DArray texSampler;                                             \n"
+    "#endif                                                                         \n"
     "layout(location = 0) out vec4 outColor;                                        \n"
     "                                                                               \n"
     "void main() {                                                                  \n"
     "	vec3 color = fColor.rgb;                                                    \n"
-    "	if (fTexID >= 0) { color *= texture(texSampler[fTexID], fTexCoord).rgb; }   \n"
+    "#if defined(TEXTURED)                                                          \n"
+    "	color *= texture(texSampler, fTexCoord).rgb;                                \n"
+    "#elif defined(LAYERED)                                                         \n"
+    "	color *= texture(texSampler, vec3(fTexCoord, fLayer)).rgb;                  \n"
+    "#endif                                                                         \n"
     "	outColor = vec4(color, 1.0);                                                \n"
     "}                                                                              \n";
 
 
-std::unique_ptr<Shader> Quad::m_Shader = nullptr;
+std::unique_ptr<ShaderVariants> Quad::m_Shader = nullptr;
 
 /////////////////////////////////////////////////////////////////////////////////////////
 /// QUAD IMPLEMENTATION /////////////////////////////////////////////////////////////////
@@ -48,25 +59,16 @@ std::unique_ptr<Shader> Quad::m_Shader = nullptr;
 Quad::Quad(uint32_t numQuads) : maxVertices(4 * numQuads) {
     // We need to initialize the shader if it is not available
     if (m_Shader == nullptr) {
-        const fs::path vtxPath = fs::temp_directory_path() / std::to_string(std::random_device()());
-        const fs::path frgPath = fs::temp_directory_path() / std::to_string(std::random_device()());
-        
-        // We use a lambda function so the file is opened, written and closed
-        auto saveFile = [](const fs::path& filePath, const std::string_view& data) { std::ofstream(filePath) << data;  };
-        saveFile(vtxPath, vertexShader);
-        saveFile(frgPath, fragmentShader);
-
-        m_Shader = std::make_unique<Shader>(vtxPath, frgPath);
-        fs::remove(vtxPath);
-        fs::remove(frgPath);
+        m_Shader = std::make_unique<ShaderVariants>(shader::Source{ vertexShader, "quad.vert" },
+                                                    shader::Source{ fragmentShader, "quad.frag" });
     }
 
     glGenVertexArrays(1, &vao);
-    glBindVertexArray(vao);
+    gl::BindVertexArray(vao);
 
     // Copying buffer to gpu
     glGenBuffers(1, &vtxBuffer);
-    glBindBuffer(GL_ARRAY_BUFFER, vtxBuffer);
+    gl::BindBuffer(GL_ARRAY_BUFFER, vtxBuffer);
     glBufferData(GL_ARRAY_BUFFER, maxVertices * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
 
     // layout for buffer
@@ -79,7 +81,8 @@ Quad::Quad(uint32_t numQuads) : maxVertices(4 * numQuads) {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *)offsetof(Vertex, texCoord));
     glEnableVertexAttribArray(2);
 
-    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void *)offsetof(Vertex, texID));
+    // Integer attributes must skip float conversion
+    glVertexAttribIPointer(3, 1, GL_INT, sizeof(Vertex), (const void *)offsetof(Vertex, layer));
     glEnableVertexAttribArray(3);
     
     // Preparing index array
@@ -95,7 +98,7 @@ Quad::Quad(uint32_t numQuads) : maxVertices(4 * numQuads) {
     }
 
     glGenBuffers(1, &idxBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, idxBuffer);
+    gl::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, idxBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, vID.size() * sizeof(uint32_t), vID.data(), GL_STATIC_DRAW);
 
     // Allocating memory for vertex buffer
@@ -103,13 +106,14 @@ Quad::Quad(uint32_t numQuads) : maxVertices(4 * numQuads) {
 }
 
 Quad::~Quad(void) {
-    glDeleteBuffers(1, &idxBuffer);
-    glDeleteBuffers(1, &vtxBuffer);
-    glDeleteVertexArrays(1, &vao);
+    gl::DeleteBuffer(idxBuffer);
+    gl::DeleteBuffer(vtxBuffer);
+    gl::DeleteVertexArray(vao);
     
     idxBuffer = vtxBuffer = vao = 0;
     vID.clear();
     vertices.clear();
+    m_Batches.clear();
 }
 
 Quad::Quad(Quad&& rhs) noexcept {
@@ -121,6 +125,7 @@ Quad::Quad(Quad&& rhs) noexcept {
     // moving vectors
     vID.swap(rhs.vID);
     vertices.swap(rhs.vertices);
+    m_Batches.swap(rhs.m_Batches);
 }   
 
 Quad& Quad::operator=(Quad&& rhs) noexcept {
@@ -149,41 +154,57 @@ void Quad::submit(const Specification& spec) {
     transform = glm::rotate(transform, spec.angle, {0.0f, 0.0f, 1.0f});
     transform = glm::scale(transform, {spec.size.x, spec.size.y, 1.0f});
 
-    int32_t texID = -1;
-    if (spec.texture) {
-        auto it = m_TextureMap.emplace(spec.texture, static_cast<int32_t>(m_TextureMap.size()));
-        texID = it.first->second;
-        ASSERT(texID < 32, "Cannot use more than 32 textures at the same draw call");
+    // New batch whenever quad samples something else than the previous one
+    const Texture* texture = spec.material ? nullptr : spec.texture;
+    if (m_Batches.empty() || m_Batches.back().texture != texture || m_Batches.back().array != spec.material.array) {
+        m_Batches.push_back({ texture, spec.material.array, static_cast<uint32_t>(vertices.size() >> 2), 0 });
     }
+    m_Batches.back().count++;
 
+    const int32_t layer = static_cast<int32_t>(spec.material.layer);
     for (uint32_t k = 0; k < 4; k++) {
         glm::vec4 vec = transform * pos[k];
-        vertices.emplace_back(Vertex{{ vec.x, vec.y, vec.z }, spec.color, tCoord[k], texID });
+        vertices.emplace_back(Vertex{{ vec.x, vec.y, vec.z }, spec.color, tCoord[k], layer });
     }
 }
 
 void Quad::draw(const glm::mat4& viewMatrix) {
-    // Preparing shader to render
-    m_Shader->bind();
-    m_Shader->setUniform("u_transform", viewMatrix);
+    frame::SetViewProjection(viewMatrix);
+    draw();
+}
 
-    for (auto [tex, id] : m_TextureMap) {
-        m_Shader->setTexture(*tex, id);
-    }
+void Quad::draw(void) {
+    // Preparing shader to render
+    frame::Upload();
 
-    // Binding buffers for render 
-    glBindVertexArray(vao);
-    glBindBuffer(GL_ARRAY_BUFFER, vtxBuffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, idxBuffer);
-    
     // Let's send our data to the GPU
-    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
-    // Issueing the draw call to all quads
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(6 * (vertices.size() >> 2)), GL_UNSIGNED_INT, 0);
+    glNamedBufferSubData(vtxBuffer, 0, vertices.size() * sizeof(Vertex), vertices.data());
+
+    // Index buffer is part of the vertex array state
+    gl::BindVertexArray(vao);
+
+    // One call per batch, each one with a single texture, so sampling is always uniform
+    for (const Batch& batch : m_Batches) {
+        if (batch.array) {
+            Shader& shader = m_Shader->get({ { "LAYERED", "" } });
+            shader.bind();
+            shader.setTexture(*batch.array);
+        }
+        else if (batch.texture) {
+            Shader& shader = m_Shader->get({ { "TEXTURED", "" } });
+            shader.bind();
+            shader.setTexture(*batch.texture);
+        }
+        else {
+            m_Shader->get().bind();
+        }
+
+        const size_t offset = 6 * size_t(batch.first) * sizeof(uint32_t);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(6 * batch.count), GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset));
+    }
 
     // Resetting for next round
-    glBindVertexArray(0);
-    m_TextureMap.clear();
+    m_Batches.clear();
     vertices.clear();
 }
 
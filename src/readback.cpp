@@ -0,0 +1,70 @@
+#include "readback.h"
+#include "glState.h"
+
+namespace GRender {
+
+Readback::Readback(size_t numBytes) : m_NumBytes(numBytes) {
+    ASSERT(numBytes > 0, "Cannot read back empty data!!");
+
+    // Client storage hints the driver to keep it in CPU memory, where we read from
+    glCreateBuffers(1, &m_BufferID);
+    glNamedBufferStorage(m_BufferID, m_NumBytes, nullptr, GL_MAP_READ_BIT | GL_CLIENT_STORAGE_BIT);
+}
+
+Readback::~Readback(void) {
+    if (m_Fence) { glDeleteSync(m_Fence); }
+    if (m_Mapped) { glUnmapNamedBuffer(m_BufferID); }
+    gl::DeleteBuffer(m_BufferID);
+}
+
+Readback::Readback(Readback&& rb) noexcept {
+    std::swap(m_BufferID, rb.m_BufferID);
+    std::swap(m_NumBytes, rb.m_NumBytes);
+    std::swap(m_Fence, rb.m_Fence);
+    std::swap(m_Mapped, rb.m_Mapped);
+}
+
+Readback& Readback::operator=(Readback&& rb) noexcept {
+    if (this != &rb) {
+        this->~Readback();
+        new(this) Readback(std::move(rb));
+    }
+    return *this;
+}
+
+void Readback::fence(void) {
+    m_Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool Readback::ready(void) const {
+    ASSERT(*this, "Readback not initialized!!");
+    if (m_Fence == nullptr) { return true; }
+
+    // Flushing makes sure the fence eventually gets signaled, even if nothing else is submitted
+    GLenum status = glClientWaitSync(m_Fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    if (status == GL_TIMEOUT_EXPIRED) { return false; }
+
+    ASSERT(status != GL_WAIT_FAILED, "Failed to wait for readback fence!!");
+    glDeleteSync(m_Fence);
+    m_Fence = nullptr;
+    return true;
+}
+
+void Readback::wait(void) const {
+    ASSERT(*this, "Readback not initialized!!");
+    if (m_Fence == nullptr) { return; }
+
+    gl::WaitFence(m_Fence);
+    m_Fence = nullptr;
+}
+
+const void* Readback::map(void) const {
+    wait();
+    if (m_Mapped == nullptr) {
+        m_Mapped = glMapNamedBufferRange(m_BufferID, 0, m_NumBytes, GL_MAP_READ_BIT);
+        ASSERT(m_Mapped, "Failed to map readback buffer!!");
+    }
+    return m_Mapped;
+}
+
+} // namespace GRender
@@ -1,40 +1,233 @@
 #include "shader.h"
 #include "texture.h"
+#include "glState.h"
+
+#include "internal/programCache.h"
 
 
 namespace fs = std::filesystem;
 
 namespace GRender {
 
+namespace shader {
+
+void EnableProgramCache(const fs::path& directory) {
+    internal::ProgramCache::Instance()->enable(directory);
+}
+
+void DisableProgramCache(void) {
+    internal::ProgramCache::Instance()->disable();
+}
+
+// GL_KHR_parallel_shader_compile is not part of our loader
+constexpr GLenum GL_COMPLETION_STATUS_KHR = 0x91B1;
+using PFNGLMAXSHADERCOMPILERTHREADSKHRPROC = void (*)(GLuint);
+
+static bool s_Async = false, s_Parallel = false;
+
+void EnableAsyncCompilation(void) {
+    s_Async = true;
+    s_Parallel = glfwExtensionSupported("GL_KHR_parallel_shader_compile");
+
+    if (s_Parallel) {
+        // Let the driver decide how many threads to use
+        auto maxThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+        if (maxThreads) { maxThreads(0xFFFFFFFF); }
+    }
+}
+
+void DisableAsyncCompilation(void) {
+    s_Async = false;
+}
+
+namespace internal {
+
+Program::Program(const std::vector<Stage>& rawStages, const Defines& defines) {
+    // Includes and defines are resolved before anything else, so the cache sees the final code
+    std::vector<std::string> codes;
+    std::vector<Stage> stages;
+    for (const Stage& stage : rawStages) {
+        m_Names += (m_Names.empty() ? "" : " -- ") + std::string(stage.source.name);
+        codes.push_back(Preprocess(stage.source, defines));
+    }
+    for (size_t k = 0; k < rawStages.size(); k++) {
+        stages.push_back({ rawStages[k].type, Source{ codes[k], rawStages[k].source.name } });
+    }
 
-Shader::Shader(const fs::path& vtxPath, const fs::path& frgPath) {
-    ASSERT(fs::exists(vtxPath), "Shader not found! => " + vtxPath.string());
-    ASSERT(fs::exists(frgPath), "Shader not found! => " + frgPath.string());
+    ProgramCache* cache = ProgramCache::Instance();
+    if (cache->enabled()) {
+        m_CacheKey = cache->hash(stages);
+        m_ProgramID = cache->load(m_CacheKey);
+        if (m_ProgramID) {
+            m_CacheKey = 0; // nothing to save
+            finalize();
+            return;
+        }
+    }
 
-    uint32_t vtx = shader::internal::CreateShader(vtxPath, GL_VERTEX_SHADER);
-    uint32_t frg = shader::internal::CreateShader(frgPath, GL_FRAGMENT_SHADER);
+    for (const Stage& stage : stages) {
+        uint32_t id = CreateShader(stage.source, stage.type);
+        m_Pending.emplace_back(id, ShaderTypeName(stage.type) + " => " + std::string(stage.source.name));
+    }
 
     // Create program
     m_ProgramID = glCreateProgram();
-    glAttachShader(m_ProgramID, vtx);
-    glAttachShader(m_ProgramID, frg);
+    for (auto& [id, name] : m_Pending) { glAttachShader(m_ProgramID, id); }
+
+    // Binaries can only be retrieved if we ask for it before linking
+    if (m_CacheKey) { glProgramParameteri(m_ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); }
 
     // Link shaders to program
     glLinkProgram(m_ProgramID);
 
-    shader::internal::CheckShaderError(m_ProgramID, GL_LINK_STATUS, true, 
-                     "Cannot link shader programs => " + vtxPath.string() + " -- " + frgPath.string());
+    // Otherwise we wait until the program is used
+    if (!s_Async) { finalize(); }
+}
+
+Program::~Program(void) {
+    for (auto& [id, name] : m_Pending) { glDeleteShader(id); }
+    gl::DeleteProgram(m_ProgramID);
+}
+
+Program::Program(Program&& program) noexcept {
+    std::swap(m_ProgramID, program.m_ProgramID);
+    std::swap(m_Finalized, program.m_Finalized);
+    std::swap(m_Pending, program.m_Pending);
+    std::swap(m_Names, program.m_Names);
+    std::swap(m_CacheKey, program.m_CacheKey);
+    std::swap(m_Uniforms, program.m_Uniforms);
+    std::swap(m_Samplers, program.m_Samplers);
+}
+
+Program& Program::operator=(Program&& program) noexcept {
+    if (this != &program) {
+        this->~Program();
+        new (this) Program(std::move(program));
+    }
+    return *this;
+}
+
+uint32_t Program::id(void) const {
+    finalize();
+    return m_ProgramID;
+}
+
+bool Program::isReady(void) const {
+    if (m_Pending.empty()) { return true; }
+    // Status is unknown without blocking, so report ready and let finalize() wait on first use
+    if (!s_Parallel) { return true; }
+
+    int status = GL_FALSE;
+    glGetProgramiv(m_ProgramID, GL_COMPLETION_STATUS_KHR, &status);
+    return status == GL_TRUE;
+}
+
+UniformHandle Program::uniform(const std::string& name) const {
+    finalize();
+    auto it = m_Uniforms.find(name);
+    return it == m_Uniforms.end() ? UniformHandle{} : UniformHandle{ it->second };
+}
+
+int32_t Program::sampler(uint32_t slot) const {
+    finalize();
+    return slot < m_Samplers.size() ? m_Samplers[slot] : -1;
+}
+
+void Program::finalize(void) const {
+    if (m_Finalized || m_ProgramID == 0) { return; }
+    m_Finalized = true;
 
-    glDeleteShader(vtx);
-    glDeleteShader(frg);
+    // Compilation errors are more informative than linking ones
+    for (auto& [id, name] : m_Pending) { CheckShaderError(id, GL_COMPILE_STATUS, false, "Shader compilation failed :: " + name); }
+    if (!m_Pending.empty()) { CheckShaderError(m_ProgramID, GL_LINK_STATUS, true, "Cannot link shader programs => " + m_Names); }
+
+    for (auto& [id, name] : m_Pending) { glDeleteShader(id); }
+    m_Pending.clear();
+
+    if (m_CacheKey) {
+        ProgramCache::Instance()->save(m_CacheKey, m_ProgramID);
+        m_CacheKey = 0;
+    }
+
+    m_Uniforms = QueryUniformLocations(m_ProgramID);
+    m_Samplers = QuerySamplerLocations(m_Uniforms);
+}
+
+// Program interface queries return properties in the same order they were requested
+static std::vector<GLint> resourceProperties(uint32_t programID, GLenum interface, GLint index, const std::vector<GLenum>& props) {
+    std::vector<GLint> values(props.size(), -1);
+    glGetProgramResourceiv(programID, interface, index, static_cast<GLsizei>(props.size()), props.data(),
+                           static_cast<GLsizei>(values.size()), nullptr, values.data());
+    return values;
+}
+
+static std::string resourceName(uint32_t programID, GLenum interface, GLint index, GLint length) {
+    std::string name(static_cast<size_t>(std::max(length, 1)), '\0');
+    GLsizei written = 0;
+    glGetProgramResourceName(programID, interface, index, length, &written, name.data());
+    name.resize(written);
+
+    // Arrays are reported by its first element
+    const size_t pos = name.rfind("[0]");
+    if (pos != std::string::npos && pos + 3 == name.size()) { name.erase(pos); }
+    return name;
+}
+
+static std::vector<Variable> queryVariables(uint32_t programID, GLenum interface) {
+    GLint count = 0;
+    glGetProgramInterfaceiv(programID, interface, GL_ACTIVE_RESOURCES, &count);
+
+    std::vector<GLenum> props = { GL_NAME_LENGTH, GL_TYPE, GL_ARRAY_SIZE, GL_LOCATION };
+    if (interface == GL_UNIFORM) { props.push_back(GL_BLOCK_INDEX); }
+
+    std::vector<Variable> variables;
+    for (GLint k = 0; k < count; k++) {
+        const std::vector<GLint> values = resourceProperties(programID, interface, k, props);
+        if (interface == GL_UNIFORM && values[4] >= 0) { continue; } // member of a block
+
+        std::string name = resourceName(programID, interface, k, values[0]);
+        if (name.rfind("gl_", 0) == 0) { continue; } // built-in inputs
+
+        variables.push_back({ std::move(name), static_cast<GLenum>(values[1]), values[2], values[3] });
+    }
+    return variables;
 }
 
-Shader::~Shader(void) {
-    glDeleteProgram(m_ProgramID);
+Reflection Program::reflect(void) const {
+    Reflection info;
+    const uint32_t programID = id();
+    if (programID == 0) { return info; }
+
+    info.uniforms = queryVariables(programID, GL_UNIFORM);
+    info.attributes = queryVariables(programID, GL_PROGRAM_INPUT);
+
+    GLint count = 0;
+    glGetProgramInterfaceiv(programID, GL_SHADER_STORAGE_BLOCK, GL_ACTIVE_RESOURCES, &count);
+    for (GLint k = 0; k < count; k++) {
+        const std::vector<GLint> values = resourceProperties(programID, GL_SHADER_STORAGE_BLOCK, k,
+                                                             { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE });
+        info.storageBlocks.push_back({ resourceName(programID, GL_SHADER_STORAGE_BLOCK, k, values[0]), values[1], values[2] });
+    }
+
+    return info;
 }
 
+} // namespace internal
+
+} // namespace shader
+
+
+Shader::Shader(const fs::path& vtxPath, const fs::path& frgPath, const shader::Defines& defines)
+    : Shader(shader::Source{ shader::internal::ReadShaderFile(vtxPath), vtxPath.string() },
+             shader::Source{ shader::internal::ReadShaderFile(frgPath), frgPath.string() }, defines) {}
+
+Shader::Shader(const shader::Source& vertex, const shader::Source& fragment, const shader::Defines& defines)
+    : m_Program({ { GL_VERTEX_SHADER, vertex }, { GL_FRAGMENT_SHADER, fragment } }, defines) {}
+
+Shader::~Shader(void) = default;
+
 Shader::Shader(Shader&& shader) noexcept {
-    std::swap(m_ProgramID, shader.m_ProgramID);
+    std::swap(m_Program, shader.m_Program);
 }
 
 Shader& Shader::operator=(Shader&& shader) noexcept {
@@ -46,16 +239,44 @@ Shader& Shader::operator=(Shader&& shader) noexcept {
 }
 
 const Shader& Shader::bind() {
-    glUseProgram(m_ProgramID);
+    gl::UseProgram(m_Program.id());
     return *this;
 }
 
+shader::UniformHandle Shader::uniform(const std::string& name) const {
+    return m_Program.uniform(name);
+}
+
 void Shader::setTexture(const Texture& tex, uint32_t slot) const {
-    const std::string name = "texSampler[" + std::to_string(slot) + "]";
- 
     tex.bind(slot);
-    int32_t loc = glGetUniformLocation(m_ProgramID, name.c_str());
-    glUniform1i(loc, slot);
+
+    int32_t loc = m_Program.sampler(slot);
+    if (loc >= 0) { glUniform1i(loc, slot); }
+}
+
+void Shader::setTexture(const TextureArray& tex, uint32_t slot) const {
+    tex.bind(slot);
+
+    int32_t loc = m_Program.sampler(slot);
+    if (loc >= 0) { glUniform1i(loc, slot); }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////////////////
+
+ShaderVariants::ShaderVariants(const shader::Source& vertex, const shader::Source& fragment)
+    : m_Vertex(vertex.code), m_VertexName(vertex.name), m_Fragment(fragment.code), m_FragmentName(fragment.name) {}
+
+Shader& ShaderVariants::get(const shader::Defines& defines) {
+    // Defines are sorted, so the same set always produces the same key
+    std::string key;
+    for (auto& [name, value] : defines) { key += name + "=" + value + ";"; }
+
+    auto it = m_Variants.find(key);
+    if (it != m_Variants.end()) { return it->second; }
+
+    shader::Source vtx{ m_Vertex, m_VertexName }, frg{ m_Fragment, m_FragmentName };
+    return m_Variants.emplace(key, Shader(vtx, frg, defines)).first->second;
 }
 
 } // namespace GRender
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include <set>
+
+#include "shaderUtils.h"
+#include "frame.h"
+
+namespace GRender::shader {
+
+// Registered code for '#include <name>'
+static std::unordered_map<std::string, std::string>& includeRegistry(void) {
+    static std::unordered_map<std::string, std::string> registry = {
+        { "GRender/frame.glsl", std::string(frame::GLSL) }
+    };
+    return registry;
+}
+
+static std::string_view trim(std::string_view line) {
+    const size_t beg = line.find_first_not_of(" \t");
+    if (beg == std::string_view::npos) { return {}; }
+    const size_t end = line.find_last_not_of(" \t\r");
+    return line.substr(beg, end - beg + 1);
+}
+
+// Recursively expands include directives. Included contains files already pasted
+static void expand(std::string_view code, const fs::path& directory, const std::string& name,
+                   std::set<std::string>& included, std::string& output) {
+    size_t lineNumber = 0;
+    size_t pos = 0;
+    while (pos < code.size()) {
+        size_t end = code.find('\n', pos);
+        if (end == std::string_view::npos) { end = code.size(); }
+
+        const std::string_view line = code.substr(pos, end - pos);
+        pos = end + 1;
+        lineNumber++;
+
+        const std::string_view directive = trim(line);
+        if (directive.rfind("#include", 0) != 0) {
+            output.append(line);
+            output.push_back('\n');
+            continue;
+        }
+
+        // Name is either between quotes or angle brackets
+        std::string_view arg = trim(directive.substr(8));
+        const bool isSystem = !arg.empty() && arg.front() == '<';
+        const char closing = isSystem ? '>' : '"';
+        const size_t close = arg.find(closing, 1);
+        ASSERT(arg.size() > 2 && (isSystem || arg.front() == '"') && close != std::string_view::npos,
+               "Invalid include directive in " + name + " (" + std::to_string(lineNumber) + ") :: " + std::string(line));
+        const std::string file(arg.substr(1, close - 1));
+
+        // Quoted names are relative to current file, but can also be found in the registry
+        std::string key, content;
+        fs::path path = directory / file;
+        auto& registry = includeRegistry();
+        if (!isSystem && fs::is_regular_file(path)) {
+            key = fs::weakly_canonical(path).string();
+            if (included.count(key) == 0) { content = internal::ReadShaderFile(path); }
+        }
+        else {
+            auto it = registry.find(file);
+            ASSERT(it != registry.end(), "Include not found in " + name + " :: " + file);
+            if (it == registry.end()) { continue; }
+
+            key = "<" + file + ">";
+            path = directory;
+            if (included.count(key) == 0) { content = it->second; }
+        }
+
+        if (!included.insert(key).second) { continue; } // already included
+        output += "#line 1\n";
+        expand(content, path.parent_path(), file, included, output);
+        output += "#line " + std::to_string(lineNumber + 1) + "\n";
+    }
+}
+
+const Variable* Reflection::findUniform(const std::string& name) const {
+    auto it = std::find_if(uniforms.begin(), uniforms.end(), [&](const Variable& var) { return var.name == name; });
+    return it == uniforms.end() ? nullptr : &(*it);
+}
+
+const StorageBlock* Reflection::findStorageBlock(const std::string& name) const {
+    auto it = std::find_if(storageBlocks.begin(), storageBlocks.end(), [&](const StorageBlock& block) { return block.name == name; });
+    return it == storageBlocks.end() ? nullptr : &(*it);
+}
+
+std::string_view TypeName(GLenum type) {
+    switch (type) {
+    case GL_INT:                        return "int";
+    case GL_UNSIGNED_INT:               return "uint";
+    case GL_FLOAT:                      return "float";
+    case GL_BOOL:                       return "bool";
+    case GL_INT_VEC2:                   return "ivec2";
+    case GL_INT_VEC3:                   return "ivec3";
+    case GL_INT_VEC4:                   return "ivec4";
+    case GL_UNSIGNED_INT_VEC2:          return "uvec2";
+    case GL_UNSIGNED_INT_VEC3:          return "uvec3";
+    case GL_UNSIGNED_INT_VEC4:          return "uvec4";
+    case GL_FLOAT_VEC2:                 return "vec2";
+    case GL_FLOAT_VEC3:                 return "vec3";
+    case GL_FLOAT_VEC4:                 return "vec4";
+    case GL_FLOAT_MAT2:                 return "mat2";
+    case GL_FLOAT_MAT3:                 return "mat3";
+    case GL_FLOAT_MAT4:                 return "mat4";
+    case GL_SAMPLER_2D:                 return "sampler2D";
+    case GL_INT_SAMPLER_2D:             return "isampler2D";
+    case GL_UNSIGNED_INT_SAMPLER_2D:    return "usampler2D";
+    case GL_SAMPLER_2D_ARRAY:           return "sampler2DArray";
+    case GL_IMAGE_2D:                   return "image2D";
+    case GL_INT_IMAGE_2D:               return "iimage2D";
+    case GL_UNSIGNED_INT_IMAGE_2D:      return "uimage2D";
+    default:                            return "unknown";
+    }
+}
+
+void RegisterInclude(const std::string& name, const std::string& code) {
+    includeRegistry()[name] = code;
+}
+
+std::string Preprocess(const Source& source, const Defines& defines) {
+    std::set<std::string> included;
+    std::string code;
+    code.reserve(source.code.size());
+    expand(source.code, fs::path(source.name).parent_path(), std::string(source.name), included, code);
+
+    if (defines.empty()) { return code; }
+
+    std::string macros;
+    for (auto& [name, value] : defines) {
+        macros += "#define " + name + (value.empty() ? "" : " " + value) + "\n";
+    }
+
+    // Defines must come after #version, otherwise they go on top
+    size_t pos = code.find("#version");
+    if (pos == std::string::npos) { return macros + code; }
+
+    size_t eol = code.find('\n', pos);
+    eol = (eol == std::string::npos) ? code.size() : eol + 1;
+
+    // Keeps line numbers in error messages matching the original source
+    const size_t line = std::count(code.begin(), code.begin() + eol, '\n') + 1;
+    return code.substr(0, eol) + macros + "#line " + std::to_string(line) + "\n" + code.substr(eol);
+}
+
+} // namespace GRender::shader
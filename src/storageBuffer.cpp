@@ -1,21 +1,38 @@
+#include <cstring>
+#include <map>
+
 #include "storageBuffer.h"
+#include "glState.h"
 
 namespace GRender {
 
-StorageBuffer::StorageBuffer(size_t numBytes, const void* data) : m_NumBytes(numBytes) {
-    glGenBuffers(1, &m_BufferID);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BufferID);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, m_NumBytes, data, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+// Ranges closer than this are uploaded together, as an extra call costs more than a few bytes
+constexpr size_t MERGE_GAP = 256;
+// Fraction of dirty bytes above which the whole buffer is uploaded
+constexpr float FULL_UPLOAD_RATIO = 0.5f;
+
+struct StorageBuffer::Deferred {
+    std::vector<uint8_t> shadow;
+    std::map<size_t, size_t> dirty; // begin -> end, never overlapping
+};
+
+StorageBuffer::StorageBuffer(size_t numBytes, const void* data) : m_NumBytes(numBytes), m_Capacity(numBytes) {
+    glCreateBuffers(1, &m_BufferID);
+    glNamedBufferData(m_BufferID, m_NumBytes, data, GL_DYNAMIC_DRAW);
 }
 
+StorageBuffer::StorageBuffer(void) = default;
+
 StorageBuffer::~StorageBuffer(void) {
-    glDeleteBuffers(1, &m_BufferID);
+    gl::DeleteBuffer(m_BufferID);
 }
 
 StorageBuffer::StorageBuffer(StorageBuffer&& buf) noexcept {
     std::swap(m_BufferID, buf.m_BufferID);
     std::swap(m_NumBytes, buf.m_NumBytes);
+    std::swap(m_Capacity, buf.m_Capacity);
+    std::swap(m_Deferred, buf.m_Deferred);
+    std::swap(m_Stats, buf.m_Stats);
 }
 
 StorageBuffer& StorageBuffer::operator=(StorageBuffer&& buf) noexcept {
@@ -28,14 +45,160 @@ StorageBuffer& StorageBuffer::operator=(StorageBuffer&& buf) noexcept {
 
 void StorageBuffer::bind(uint32_t location) const {
     ASSERT(*this, "StorageBuffer not initialized!!");
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BufferID);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, location, m_BufferID);
+    flush();
+    gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_SHADER_STORAGE_BARRIER_BIT);
+    gl::BindBufferBase(GL_SHADER_STORAGE_BUFFER, location, m_BufferID);
+}
+
+void StorageBuffer::reserve(size_t numBytes) {
+    if (numBytes <= m_Capacity && m_BufferID > 0) { return; }
+    flush();
+
+    uint32_t bufferID = 0;
+    glCreateBuffers(1, &bufferID);
+    glNamedBufferData(bufferID, numBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    if (m_BufferID > 0 && m_NumBytes > 0) {
+        // Copy happens on the GPU, but it must see pending shader writes
+        gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glCopyNamedBufferSubData(m_BufferID, bufferID, 0, 0, m_NumBytes);
+    }
+
+    gl::DeleteBuffer(m_BufferID);
+    m_BufferID = bufferID;
+    m_Capacity = numBytes;
+}
+
+void StorageBuffer::resize(size_t numBytes) {
+    if (numBytes > m_Capacity) { reserve(std::max(numBytes, 2 * m_Capacity)); }
+    m_NumBytes = numBytes;
+
+    if (m_Deferred) {
+        auto& dirty = m_Deferred->dirty;
+        dirty.erase(dirty.lower_bound(numBytes), dirty.end());
+        if (!dirty.empty()) {
+            size_t& end = std::prev(dirty.end())->second;
+            end = std::min(end, numBytes);
+        }
+        m_Deferred->shadow.resize(numBytes);
+    }
+}
+
+Readback StorageBuffer::readAsync(size_t offset, size_t numBytes) const {
+    ASSERT(*this, "StorageBuffer not initialized!!");
+    if (numBytes == 0) { numBytes = m_NumBytes - offset; }
+    ASSERT(offset + numBytes <= m_NumBytes, "Readback range is out of buffer bounds!!");
+
+    Readback readback(numBytes);
+    flush();
+    gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+    glCopyNamedBufferSubData(m_BufferID, readback.m_BufferID, offset, 0, numBytes);
+    readback.fence();
+    return readback;
 }
 
 void StorageBuffer::update(const void* data, size_t offset, size_t numBytes) {
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_BufferID);
-    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, numBytes == 0 ? m_NumBytes : numBytes, data);
-    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (numBytes == 0) { numBytes = m_NumBytes - offset; }
+    ASSERT(offset + numBytes <= m_NumBytes, "Update is out of buffer bounds!!");
+    m_Stats.updates++;
+
+    if (!m_Deferred) {
+        gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+        glNamedBufferSubData(m_BufferID, offset, numBytes, data);
+        m_Stats.uploads++;
+        m_Stats.bytesUploaded += numBytes;
+        return;
+    }
+
+    std::memcpy(m_Deferred->shadow.data() + offset, data, numBytes);
+
+    // Merging with every range touching [beg - gap, end + gap]
+    size_t beg = offset, end = offset + numBytes;
+    auto& dirty = m_Deferred->dirty;
+    auto it = dirty.upper_bound(end + MERGE_GAP);
+    while (it != dirty.begin()) {
+        auto prev = std::prev(it);
+        if (prev->second + MERGE_GAP < beg) { break; }
+        beg = std::min(beg, prev->first);
+        end = std::max(end, prev->second);
+        it = dirty.erase(prev);
+    }
+    dirty[beg] = end;
+}
+
+void StorageBuffer::setDeferred(bool deferred) {
+    if (deferred == isDeferred()) { return; }
+
+    if (deferred) {
+        // Starting from current contents, so partial updates don't upload garbage
+        m_Deferred = std::make_unique<Deferred>();
+        m_Deferred->shadow = getBuffer<uint8_t>(0, m_NumBytes);
+    }
+    else {
+        flush();
+        m_Deferred.reset();
+    }
+}
+
+void StorageBuffer::flush(void) const {
+    if (!m_Deferred || m_Deferred->dirty.empty()) { return; }
+
+    auto& [shadow, dirty] = *m_Deferred;
+    size_t dirtyBytes = 0;
+    for (auto& [beg, end] : dirty) { dirtyBytes += end - beg; }
+
+    gl::Consume(gl::Resource::BUFFER, m_BufferID, GL_BUFFER_UPDATE_BARRIER_BIT);
+    if (dirtyBytes > FULL_UPLOAD_RATIO * m_NumBytes) {
+        // Orphaning lets the driver hand us fresh memory instead of waiting for the GPU
+        glInvalidateBufferData(m_BufferID);
+        glNamedBufferSubData(m_BufferID, 0, m_NumBytes, shadow.data());
+        m_Stats.uploads++;
+        m_Stats.fullUploads++;
+        m_Stats.bytesUploaded += m_NumBytes;
+    }
+    else {
+        for (auto& [beg, end] : dirty) {
+            glNamedBufferSubData(m_BufferID, beg, end - beg, shadow.data() + beg);
+            m_Stats.uploads++;
+            m_Stats.bytesUploaded += end - beg;
+        }
+    }
+
+    dirty.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+AppendBuffer::AppendBuffer(size_t elementBytes, size_t capacity)
+    : m_Data(elementBytes * capacity), m_Counter(sizeof(uint32_t)), m_ElementBytes(elementBytes) {
+    ASSERT(elementBytes > 0 && elementBytes % 4 == 0, "Element size must be a multiple of 4 bytes!!");
+    reset();
+}
+
+void AppendBuffer::reset(void) {
+    ASSERT(*this, "AppendBuffer not initialized!!");
+    const uint32_t zero = 0;
+    gl::Consume(gl::Resource::BUFFER, m_Counter.id(), GL_BUFFER_UPDATE_BARRIER_BIT);
+    glClearNamedBufferData(m_Counter.id(), GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+}
+
+void AppendBuffer::reserve(size_t capacity) {
+    ASSERT(*this, "AppendBuffer not initialized!!");
+    // Whole allocation stays in use, as producers see it through items.length()
+    if (capacity > this->capacity()) { m_Data.resize(std::max(capacity * m_ElementBytes, 2 * m_Data.numBytes())); }
+}
+
+uint32_t AppendBuffer::count(void) const {
+    ASSERT(*this, "AppendBuffer not initialized!!");
+    return m_Counter.getBuffer<uint32_t>().front();
+}
+
+bool AppendBuffer::fit(void) {
+    const size_t needed = count();
+    if (needed <= capacity()) { return true; }
+
+    reserve(needed);
+    return false;
 }
 
-} // namespace GRender
\ No newline at end of file
+} // namespace GRender
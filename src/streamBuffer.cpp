@@ -0,0 +1,75 @@
+#include "streamBuffer.h"
+#include "glState.h"
+
+namespace GRender {
+
+StreamBuffer::StreamBuffer(size_t regionBytes, uint32_t numRegions) : m_RegionBytes(regionBytes) {
+    ASSERT(regionBytes > 0 && numRegions > 0, "StreamBuffer needs at least one non-empty region!!");
+
+    // Regions must start at offsets valid for any indexed binding
+    GLint ssboAlign = 0, uboAlign = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssboAlign);
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uboAlign);
+    const size_t align = std::max<size_t>({ 1, size_t(ssboAlign), size_t(uboAlign) });
+    m_Stride = (regionBytes + align - 1) / align * align;
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &m_BufferID);
+    glNamedBufferStorage(m_BufferID, m_Stride * numRegions, nullptr, flags);
+    m_Mapped = glMapNamedBufferRange(m_BufferID, 0, m_Stride * numRegions, flags);
+    ASSERT(m_Mapped, "Failed to map stream buffer!!");
+
+    m_Fences.resize(numRegions, nullptr);
+}
+
+StreamBuffer::~StreamBuffer(void) {
+    for (GLsync fence : m_Fences) {
+        if (fence) { glDeleteSync(fence); }
+    }
+    if (m_Mapped) { glUnmapNamedBuffer(m_BufferID); }
+    gl::DeleteBuffer(m_BufferID);
+}
+
+StreamBuffer::StreamBuffer(StreamBuffer&& buf) noexcept {
+    std::swap(m_BufferID, buf.m_BufferID);
+    std::swap(m_Mapped, buf.m_Mapped);
+    std::swap(m_RegionBytes, buf.m_RegionBytes);
+    std::swap(m_Stride, buf.m_Stride);
+    std::swap(m_Fences, buf.m_Fences);
+    std::swap(m_Current, buf.m_Current);
+    std::swap(m_Stalls, buf.m_Stalls);
+}
+
+StreamBuffer& StreamBuffer::operator=(StreamBuffer&& buf) noexcept {
+    if (this != &buf) {
+        this->~StreamBuffer();
+        new(this) StreamBuffer(std::move(buf));
+    }
+    return *this;
+}
+
+void* StreamBuffer::next(void) {
+    ASSERT(*this, "StreamBuffer not initialized!!");
+
+    // Everything reading the current region was already queued
+    GLsync& previous = m_Fences[m_Current];
+    if (previous) { glDeleteSync(previous); }
+    previous = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_Current = (m_Current + 1) % numRegions();
+
+    GLsync& fence = m_Fences[m_Current];
+    if (fence) {
+        if (gl::WaitFence(fence)) { m_Stalls++; }
+        fence = nullptr;
+    }
+
+    return data();
+}
+
+void StreamBuffer::bind(uint32_t location, GLenum target) const {
+    ASSERT(*this, "StreamBuffer not initialized!!");
+    gl::BindBufferRange(target, location, m_BufferID, offset(), m_RegionBytes);
+}
+
+} // namespace GRender
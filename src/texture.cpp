@@ -1,8 +1,16 @@
 #include "texture.h"
+#include "computeShader.h"
+#include "glState.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+// S3TC is an extension, but every desktop driver supports it
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace GRender {
 using namespace texture;
 
@@ -13,12 +21,27 @@ static std::tuple<GLenum, GLenum, GLenum> convertToGLFormat(Format fmt) {
     case Format::INTEGER:           return { GL_R32I,  GL_RED_INTEGER, GL_INT };
     case Format::UNSIGNED_INTEGER:  return { GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT };
     case Format::FLOAT:             return { GL_R32F,  GL_RED, GL_FLOAT };
+    case Format::BC1:               return { GL_COMPRESSED_RGBA_S3TC_DXT1_EXT, 0, 0 };
+    case Format::BC3:               return { GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 0, 0 };
+    case Format::BC7:               return { GL_COMPRESSED_RGBA_BPTC_UNORM, 0, 0 };
     default:
         ASSERT(false, "Texture format not supported!!");
         return {0,0,0};
     }
 }
 
+static size_t bytesPerPixel(Format fmt) {
+    switch (fmt) {
+    case Format::RGBA32: return 4 * sizeof(float);
+    case Format::NONE:   return 0;
+    default:             return 4;
+    }
+}
+
+static size_t bytesPerBlock(Format fmt) {
+    return fmt == Format::BC1 ? 8 : 16;
+}
+
 static GLint convertToGLFilter(Filter filter) {
     switch (filter) {
     case Filter::LINEAR:  return GL_LINEAR;
@@ -29,6 +52,16 @@ static GLint convertToGLFilter(Filter filter) {
     }
 }
 
+// Minification also picks how levels are combined
+static GLint convertToGLMinFilter(Filter min, Filter mipmap, uint32_t levels) {
+    if (levels == 1) { return convertToGLFilter(min); }
+
+    if (min == Filter::LINEAR) {
+        return mipmap == Filter::LINEAR ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+    }
+    return mipmap == Filter::LINEAR ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
+}
+
 static GLint convertToGLWrap(Wrap wrap) {
     switch (wrap) {
     case Wrap::REPEAT:   return GL_REPEAT;
@@ -40,32 +73,76 @@ static GLint convertToGLWrap(Wrap wrap) {
     }
 }
 
-Texture::Texture(const glm::uvec2& size, const Specification& spec, const void* data) : m_Size(size), m_Spec(spec) {
-    glGenTextures(1, &m_TexID);
-    glBindTexture(GL_TEXTURE_2D, m_TexID);
-
-    auto [intFmt, fmt, tp] = convertToGLFormat(spec.fmt);
-    glTextureStorage2D(m_TexID, 1, intFmt, size.x, size.y);
-    if (data) { glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y, fmt, tp, data); }
+// Full chain has one level per halving of the largest side
+static uint32_t numLevels(const glm::uvec2& size, uint32_t requested) {
+    const uint32_t maxLevels = 1 + static_cast<uint32_t>(std::log2(std::max({ size.x, size.y, 1u })));
+    return requested == 0 ? maxLevels : std::min(requested, maxLevels);
+}
 
+static void setParameters(uint32_t texID, const Specification& spec, uint32_t levels) {
     // Wrap mode
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, convertToGLWrap(spec.wrap.x));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, convertToGLWrap(spec.wrap.y));
+    glTextureParameteri(texID, GL_TEXTURE_WRAP_S, convertToGLWrap(spec.wrap.x));
+    glTextureParameteri(texID, GL_TEXTURE_WRAP_T, convertToGLWrap(spec.wrap.y));
 
     // Min mag filters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, convertToGLFilter(spec.filter.min));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, convertToGLFilter(spec.filter.mag));
+    glTextureParameteri(texID, GL_TEXTURE_MIN_FILTER, convertToGLMinFilter(spec.filter.min, spec.filter.mipmap, levels));
+    glTextureParameteri(texID, GL_TEXTURE_MAG_FILTER, convertToGLFilter(spec.filter.mag));
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (spec.anisotropy > 1.0f) {
+        float maxAnisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+        glTextureParameterf(texID, GL_TEXTURE_MAX_ANISOTROPY, std::min(spec.anisotropy, maxAnisotropy));
+    }
+}
+
+namespace texture {
+
+size_t NumBytes(Format fmt, const glm::uvec2& size) {
+    if (IsCompressed(fmt)) {
+        const glm::uvec2 blocks = (size + 3u) / 4u;
+        return size_t(blocks.x) * blocks.y * bytesPerBlock(fmt);
+    }
+    return size_t(size.x) * size.y * bytesPerPixel(fmt);
+}
+
+bool operator==(const Specification& a, const Specification& b) {
+    return a.fmt == b.fmt && a.filter.min == b.filter.min && a.filter.mag == b.filter.mag
+        && a.filter.mipmap == b.filter.mipmap && a.wrap.x == b.wrap.x && a.wrap.y == b.wrap.y
+        && a.levels == b.levels && a.autoMipmaps == b.autoMipmaps && a.anisotropy == b.anisotropy;
+}
+
+} // namespace texture
+
+Texture::Texture(const glm::uvec2& size, const Specification& spec, const void* data) : m_Size(size), m_Spec(spec) {
+    // Direct state access, so we never disturb texture units
+    glCreateTextures(GL_TEXTURE_2D, 1, &m_TexID);
+    m_Levels = numLevels(size, spec.levels);
+
+    auto [intFmt, fmt, tp] = convertToGLFormat(spec.fmt);
+    glTextureStorage2D(m_TexID, m_Levels, intFmt, size.x, size.y);
+    setParameters(m_TexID, spec, m_Levels);
+
+    if (data) { update(data); }
 }
 
 Texture::~Texture(void) {
-    glDeleteTextures(1, &m_TexID);
+    gl::DeleteTexture(m_TexID);
+}
+
+size_t Texture::numBytes(void) const {
+    size_t total = 0;
+    glm::uvec2 size = m_Size;
+    for (uint32_t level = 0; level < m_Levels; level++) {
+        total += NumBytes(m_Spec.fmt, size);
+        size = glm::max(size / 2u, glm::uvec2(1));
+    }
+    return total;
 }
 
 Texture::Texture(Texture&& tex) noexcept {
     std::swap(m_TexID, tex.m_TexID);
     std::swap(m_Size, tex.m_Size);
+    std::swap(m_Levels, tex.m_Levels);
     std::swap(m_Spec, tex.m_Spec);
 }
 
@@ -80,18 +157,123 @@ Texture& Texture::operator=(Texture&& tex) noexcept {
 void Texture::bind(uint32_t slot) const {
     ASSERT(*this, "Texture not initialized!!");
     ASSERT(slot < 32, "Maximum gpu texture slot exceeded");
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, m_TexID);
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_FETCH_BARRIER_BIT);
+    gl::BindTexture(slot, m_TexID);
 }
 
 
 void Texture::update(const void* data) {
-    glBindTexture(GL_TEXTURE_2D, m_TexID);
+    updateLevel(0, data);
+    if (m_Spec.autoMipmaps && !IsCompressed(m_Spec.fmt)) { generateMipmaps(); }
+}
 
+void Texture::updateLevel(uint32_t level, const void* data) {
+    ASSERT(level < m_Levels, "Level out of range :: " + std::to_string(level));
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    const glm::uvec2 size = glm::max(m_Size >> level, glm::uvec2(1));
     auto [intFmt, fmt, tp] = convertToGLFormat(m_Spec.fmt);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Size.x, m_Size.y, fmt, tp, data);
+    if (IsCompressed(m_Spec.fmt)) {
+        const GLsizei numBytes = static_cast<GLsizei>(NumBytes(m_Spec.fmt, size));
+        glCompressedTextureSubImage2D(m_TexID, level, 0, 0, size.x, size.y, intFmt, numBytes, data);
+    }
+    else {
+        glTextureSubImage2D(m_TexID, level, 0, 0, size.x, size.y, fmt, tp, data);
+    }
+}
+
+// Each thread writes one texel of the next level from a 2x2 block of the previous one,
+// clamping at the border so odd sizes still work
+constexpr std::string_view downsampleShader =
+    "#version 450 core                                                              \n"
+    "layout(local_size_x = 8, local_size_y = 8) in;                                 \n"
+    "                                                                               \n"
+    "layout(FORMAT, binding = 0) uniform readonly IMAGE src;                        \n"
+    "layout(FORMAT, binding = 1) uniform writeonly IMAGE dst;                       \n"
+    "                                                                               \n"
+    "void main() {                                                                  \n"
+    "    ivec2 pos = ivec2(gl_GlobalInvocationID.xy);                               \n"
+    "    if (any(greaterThanEqual(pos, imageSize(dst)))) { return; }                \n"
+    "                                                                               \n"
+    "#ifdef AVERAGE                                                                 \n"
+    "    ivec2 last = imageSize(src) - 1;                                           \n"
+    "    vec4 sum = imageLoad(src, min(2 * pos, last))                              \n"
+    "             + imageLoad(src, min(2 * pos + ivec2(1, 0), last))                \n"
+    "             + imageLoad(src, min(2 * pos + ivec2(0, 1), last))                \n"
+    "             + imageLoad(src, min(2 * pos + ivec2(1, 1), last));               \n"
+    "    imageStore(dst, pos, 0.25 * sum);                                          \n"
+    "#else                                                                          \n"
+    "    imageStore(dst, pos, imageLoad(src, 2 * pos));                             \n"
+    "#endif                                                                         \n"
+    "}                                                                              \n";
+
+static ComputeShader& downsampleKernel(Format fmt) {
+    // Compiled the first time each format needs it
+    static std::unordered_map<Format, ComputeShader> kernels;
+
+    auto it = kernels.find(fmt);
+    if (it != kernels.end()) { return it->second; }
+
+    shader::Defines defines;
+    switch (fmt) {
+    case Format::RGBA32:           defines = { { "FORMAT", "rgba32f" }, { "IMAGE", "image2D" }, { "AVERAGE", "" } }; break;
+    case Format::FLOAT:            defines = { { "FORMAT", "r32f" }, { "IMAGE", "image2D" }, { "AVERAGE", "" } }; break;
+    case Format::INTEGER:          defines = { { "FORMAT", "r32i" }, { "IMAGE", "iimage2D" } }; break;
+    case Format::UNSIGNED_INTEGER: defines = { { "FORMAT", "r32ui" }, { "IMAGE", "uimage2D" } }; break;
+    default:
+        ASSERT(false, "Texture format cannot be downsampled!!");
+        break;
+    }
+
+    return kernels.emplace(fmt, ComputeShader(shader::Source{ downsampleShader, "downsample.comp" }, defines)).first->second;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+void Texture::generateMipmaps(void) {
+    ASSERT(*this, "Texture not initialized!!");
+    if (m_Levels == 1) { return; }
+
+    if (IsCompressed(m_Spec.fmt)) {
+        WARN("Mipmaps of compressed textures must be uploaded with updateLevel");
+        return;
+    }
+
+    if (m_Spec.fmt == Format::RGBA8) {
+        gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        glGenerateTextureMipmap(m_TexID);
+        return;
+    }
+
+    // Leaves kernel and image units 0 and 1 bound
+    ComputeShader& kernel = downsampleKernel(m_Spec.fmt);
+    kernel.bind();
+    for (uint32_t level = 1; level < m_Levels; level++) {
+        const glm::uvec2 size = glm::max(m_Size >> level, glm::uvec2(1));
+        kernel.setTexture(*this, 0, shader::Access::READ_ONLY, level - 1);
+        kernel.setTexture(*this, 1, shader::Access::WRITE_ONLY, level);
+        kernel.dispatchThreads({ size, 1 });
+    }
+}
+
+Readback Texture::readAsync(void) const {
+    ASSERT(*this, "Texture not initialized!!");
+    const size_t numBytes = NumBytes(m_Spec.fmt, m_Size);
+
+    Readback readback(numBytes);
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // Pixels go into the staging buffer bound as pack buffer
+    auto [intFmt, fmt, tp] = convertToGLFormat(m_Spec.fmt);
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, readback.m_BufferID);
+    if (IsCompressed(m_Spec.fmt)) {
+        glGetCompressedTextureImage(m_TexID, 0, static_cast<GLsizei>(numBytes), nullptr);
+    }
+    else {
+        glGetTextureImage(m_TexID, 0, fmt, tp, static_cast<GLsizei>(numBytes), nullptr);
+    }
+    gl::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback.fence();
+    return readback;
 }
 
 void Texture::resize(const glm::uvec2& size) {
@@ -100,6 +282,154 @@ void Texture::resize(const glm::uvec2& size) {
     new (this) Texture(size, locSpec);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+
+TextureArray::TextureArray(const glm::uvec2& size, uint32_t numLayers, const Specification& spec)
+    : m_Size(size), m_NumLayers(numLayers), m_Spec(spec) {
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    ASSERT(numLayers > 0 && numLayers <= uint32_t(maxLayers), "Invalid number of layers :: " + std::to_string(numLayers));
+
+    m_Levels = numLevels(size, spec.levels);
+    if (m_Levels > 1 && spec.fmt != Format::RGBA8) {
+        WARN("Texture arrays only have mipmaps for RGBA8, using a single level");
+        m_Levels = 1;
+    }
+
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &m_TexID);
+
+    auto [intFmt, fmt, tp] = convertToGLFormat(spec.fmt);
+    glTextureStorage3D(m_TexID, m_Levels, intFmt, size.x, size.y, numLayers);
+    setParameters(m_TexID, spec, m_Levels);
+}
+
+TextureArray::~TextureArray(void) {
+    gl::DeleteTexture(m_TexID);
+}
+
+TextureArray::TextureArray(TextureArray&& tex) noexcept {
+    std::swap(m_TexID, tex.m_TexID);
+    std::swap(m_Size, tex.m_Size);
+    std::swap(m_NumLayers, tex.m_NumLayers);
+    std::swap(m_Levels, tex.m_Levels);
+    std::swap(m_Spec, tex.m_Spec);
+    std::swap(m_MipsDirty, tex.m_MipsDirty);
+}
+
+TextureArray& TextureArray::operator=(TextureArray&& tex) noexcept {
+    if (this != &tex) {
+        this->~TextureArray();
+        new(this) TextureArray(std::move(tex));
+    }
+    return *this;
+}
+
+void TextureArray::bind(uint32_t slot) const {
+    ASSERT(*this, "TextureArray not initialized!!");
+    ASSERT(slot < 32, "Maximum gpu texture slot exceeded");
+    if (m_MipsDirty) { buildMipmaps(); }
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_FETCH_BARRIER_BIT);
+    gl::BindTexture(slot, m_TexID);
+}
+
+void TextureArray::update(uint32_t layer, const void* data) {
+    ASSERT(layer < m_NumLayers, "Layer out of range :: " + std::to_string(layer));
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    auto [intFmt, fmt, tp] = convertToGLFormat(m_Spec.fmt);
+    if (IsCompressed(m_Spec.fmt)) {
+        const GLsizei numBytes = static_cast<GLsizei>(NumBytes(m_Spec.fmt, m_Size));
+        glCompressedTextureSubImage3D(m_TexID, 0, 0, 0, layer, m_Size.x, m_Size.y, 1, intFmt, numBytes, data);
+    }
+    else {
+        glTextureSubImage3D(m_TexID, 0, 0, 0, layer, m_Size.x, m_Size.y, 1, fmt, tp, data);
+    }
+
+    // Mipmaps cover the whole array, so they are generated once before it gets sampled
+    m_MipsDirty |= m_Spec.autoMipmaps && m_Levels > 1;
+}
+
+void TextureArray::copy(uint32_t layer, const Texture& texture) {
+    ASSERT(layer < m_NumLayers, "Layer out of range :: " + std::to_string(layer));
+    ASSERT(texture.size() == m_Size && texture.specification().fmt == m_Spec.fmt, "Texture doesn't match array size and format!!");
+
+    gl::Consume(gl::Resource::TEXTURE, texture.id(), GL_TEXTURE_UPDATE_BARRIER_BIT);
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // Levels available in both are copied, the rest is generated
+    const uint32_t levels = std::min(texture.levels(), m_Levels);
+    for (uint32_t level = 0; level < levels; level++) {
+        const glm::uvec2 size = glm::max(m_Size >> level, glm::uvec2(1));
+        glCopyImageSubData(texture.id(), GL_TEXTURE_2D, level, 0, 0, 0,
+                           m_TexID, GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size.x, size.y, 1);
+    }
+
+    m_MipsDirty |= levels < m_Levels && m_Spec.autoMipmaps;
+}
+
+void TextureArray::generateMipmaps(void) {
+    ASSERT(*this, "TextureArray not initialized!!");
+    if (m_Levels == 1) { return; }
+    buildMipmaps();
+}
+
+void TextureArray::buildMipmaps(void) const {
+    m_MipsDirty = false;
+    gl::Consume(gl::Resource::TEXTURE, m_TexID, GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glGenerateTextureMipmap(m_TexID);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextureStream::TextureStream(const glm::uvec2& size, Format fmt, uint32_t numBuffers)
+    : m_Size(size), m_Format(fmt), m_FrameBytes(NumBytes(fmt, size)) {
+    ASSERT(m_FrameBytes > 0 && numBuffers > 0, "TextureStream needs a valid size, format and number of buffers!!");
+    ASSERT(!IsCompressed(fmt), "TextureStream doesn't support compressed formats!!");
+
+    m_Buffer = StreamBuffer(m_FrameBytes, numBuffers);
+}
+
+TextureStream::TextureStream(TextureStream&& stream) noexcept {
+    std::swap(m_Buffer, stream.m_Buffer);
+    std::swap(m_Size, stream.m_Size);
+    std::swap(m_Format, stream.m_Format);
+    std::swap(m_FrameBytes, stream.m_FrameBytes);
+    std::swap(m_Acquired, stream.m_Acquired);
+}
+
+TextureStream& TextureStream::operator=(TextureStream&& stream) noexcept {
+    if (this != &stream) {
+        this->~TextureStream();
+        new(this) TextureStream(std::move(stream));
+    }
+    return *this;
+}
+
+void* TextureStream::acquire(void) {
+    ASSERT(*this, "TextureStream not initialized!!");
+    ASSERT(!m_Acquired, "Previous frame was acquired without being submitted!!");
+
+    // Upload of the previous frame is already queued, so its region gets fenced here
+    m_Acquired = true;
+    return m_Buffer.next();
+}
+
+void TextureStream::submit(Texture& texture) {
+    ASSERT(m_Acquired, "No acquired frame to submit!!");
+    ASSERT(texture.size() == m_Size && texture.specification().fmt == m_Format, "Texture doesn't match stream size and format!!");
+    m_Acquired = false;
+
+    gl::Consume(gl::Resource::TEXTURE, texture.id(), GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+    // With an unpack buffer bound, the data pointer is an offset into it
+    auto [intFmt, fmt, tp] = convertToGLFormat(m_Format);
+    gl::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffer.id());
+    glTextureSubImage2D(texture.id(), 0, 0, 0, m_Size.x, m_Size.y, fmt, tp, reinterpret_cast<const void*>(m_Buffer.offset()));
+    gl::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (texture.specification().autoMipmaps) { texture.generateMipmaps(); }
+}
+
 namespace utils {
 
 Texture createTextureFromRGBAFile(const fs::path& filepath, Specification spec) {
@@ -113,6 +443,10 @@ Texture createTextureFromRGBAFile(const fs::path& filepath, Specification spec)
     int width, height, nrChannels;
     stbi_set_flip_vertically_on_load(1);
     uint8_t* data = stbi_load(filepath.string().c_str(), &width, &height, &nrChannels, 4);
+    if (data == nullptr) {
+        WARN("Failed to decode image :: " + filepath.string());
+        return Texture();
+    }
 
     Texture texture({ width, height }, spec, data);
     stbi_image_free(data);
@@ -0,0 +1,105 @@
+#include "textureCache.h"
+#include "textureLoader.h"
+
+namespace GRender {
+
+TextureCache::TextureCache(size_t budgetBytes, TextureLoader* loader) : m_Loader(loader), m_Budget(budgetBytes) {}
+
+std::shared_ptr<Texture> TextureCache::get(const fs::path& filepath, const texture::Specification& spec) {
+    dropFailed();
+    const std::string& key = canonicalKey(filepath);
+
+    auto [beg, end] = m_Lookup.equal_range(key);
+    for (auto it = beg; it != end; it++) {
+        if (it->second->spec != spec) { continue; }
+
+        m_Stats.hits++;
+        m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+        return it->second->texture;
+    }
+
+    m_Stats.misses++;
+    std::shared_ptr<Texture> texture;
+    if (m_Loader) {
+        // Failures are only known once the loader gets to the file, so they are dropped later
+        auto loaded = std::make_shared<std::weak_ptr<Texture>>();
+        texture = m_Loader->load(filepath, spec, [failed = m_Failed, loaded](const fs::path&, bool success) {
+            if (!success) { failed->push_back(*loaded); }
+        });
+        *loaded = texture;
+    }
+    else {
+        texture = std::make_shared<Texture>(utils::createTextureFromRGBAFile(filepath, spec));
+        if (!*texture) { return texture; } // not cached, so next get tries again
+    }
+
+    // Loader allocates all the memory right away, so size is already known
+    const size_t numBytes = texture->numBytes();
+    m_Entries.push_front({ key, spec, texture, numBytes });
+    m_Lookup.emplace(key, m_Entries.begin());
+    m_Usage += numBytes;
+
+    // New texture is held by us, so it's safe from eviction
+    trim();
+    return texture;
+}
+
+// Canonical paths need filesystem calls, too slow for every get of every frame
+const std::string& TextureCache::canonicalKey(const fs::path& filepath) {
+    auto it = m_Canonical.find(filepath.native());
+    if (it == m_Canonical.end()) { it = m_Canonical.emplace(filepath.native(), fs::weakly_canonical(filepath).string()).first; }
+    return it->second;
+}
+
+void TextureCache::erase(Iterator it) {
+    auto [beg, end] = m_Lookup.equal_range(it->key);
+    for (auto lookup = beg; lookup != end; lookup++) {
+        if (lookup->second == it) {
+            m_Lookup.erase(lookup);
+            break;
+        }
+    }
+
+    m_Usage -= it->numBytes;
+    m_Entries.erase(it);
+}
+
+void TextureCache::dropFailed(void) {
+    for (const std::weak_ptr<Texture>& failed : *m_Failed) {
+        std::shared_ptr<Texture> texture = failed.lock();
+        if (texture == nullptr) { continue; } // nobody holds it, so it was already evicted
+
+        auto it = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const Entry& entry) { return entry.texture == texture; });
+        if (it != m_Entries.end()) { erase(it); }
+    }
+    m_Failed->clear();
+}
+
+void TextureCache::evict(size_t budget) {
+    auto it = m_Entries.end();
+    while (m_Usage > budget && it != m_Entries.begin()) {
+        it--;
+        if (it->texture.use_count() > 1) { continue; } // still in use
+
+        m_Stats.evictions++;
+        erase(it++);
+    }
+}
+
+void TextureCache::trim(void) {
+    dropFailed();
+    evict(m_Budget);
+}
+
+void TextureCache::clear(void) {
+    dropFailed();
+    evict(0);
+    m_Canonical.clear();
+}
+
+void TextureCache::setBudget(size_t budgetBytes) {
+    m_Budget = budgetBytes;
+    trim();
+}
+
+} // namespace GRender
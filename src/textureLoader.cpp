@@ -0,0 +1,188 @@
+#include <cstring>
+
+#include "textureLoader.h"
+#include "mailbox.h"
+#include "glState.h"
+
+#include "stb_image.h"
+
+namespace GRender {
+
+TextureLoader::TextureLoader(uint32_t numThreads, size_t uploadBudget) : m_Budget(uploadBudget) {
+    ASSERT(numThreads > 0 && uploadBudget > 0, "TextureLoader needs at least one thread and some upload budget!!");
+
+    // Regions stay untouched until the GPU is done uploading from them
+    m_Staging = StreamBuffer(uploadBudget, 3);
+
+    for (uint32_t k = 0; k < numThreads; k++) {
+        m_Workers.emplace_back(&TextureLoader::work, this);
+    }
+}
+
+TextureLoader::~TextureLoader(void) {
+    // Mailbox keeps the progress bar, but its cancel button must never call us again
+    if (m_Progress) {
+        m_Progress->is_read = true;
+        m_Progress = nullptr;
+    }
+
+    // Every queued file still gets its callback
+    cancel();
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Quit = true;
+    }
+    m_Condition.notify_all();
+
+    for (std::thread& worker : m_Workers) { worker.join(); }
+
+    // Files workers were decoding when we canceled
+    cancel();
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const fs::path& filepath, const texture::Specification& spec, const Callback& callback) {
+    ASSERT(spec.fmt == texture::Format::RGBA8, "Expected RGBA8 texture format specification!!");
+
+    auto job = std::make_unique<Job>();
+    job->path = filepath;
+    job->callback = callback;
+
+    // Header is tiny, so we know the size right away
+    int width = 0, height = 0, channels = 0;
+    if (stbi_info(filepath.string().c_str(), &width, &height, &channels)) {
+        job->size = { width, height };
+    }
+    else {
+        WARN("Cannot read image header :: " + filepath.string());
+        job->size = { 1, 1 };
+        job->failed = true;
+    }
+    ASSERT(4ull * job->size.x <= m_Budget, "Upload budget is smaller than a single row of " + filepath.string());
+
+    auto texture = std::make_shared<Texture>(job->size, spec);
+    for (uint32_t level = 0; level < texture->levels(); level++) {
+        glClearTexImage(texture->id(), level, GL_RGBA, GL_FLOAT, &m_Placeholder);
+    }
+    job->texture = texture;
+
+    m_Total++;
+    if (m_ShowProgress && m_Progress == nullptr) {
+        m_Progress = mailbox::CreateProgress("Loading textures", [this]() {
+            m_Progress = nullptr; // mailbox owns it and may delete it once canceled
+            cancel();
+        });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        (job->failed ? m_Decoded : m_Queue).push_back(std::move(job));
+    }
+    m_Condition.notify_one();
+
+    return texture;
+}
+
+void TextureLoader::work(void) {
+    // Textures have their origin at the bottom
+    stbi_set_flip_vertically_on_load_thread(1);
+
+    while (true) {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Condition.wait(lock, [&]() { return m_Quit || !m_Queue.empty(); });
+            if (m_Quit) { return; }
+
+            job = std::move(m_Queue.front());
+            m_Queue.pop_front();
+        }
+
+        if (!job->texture.expired()) {
+            int width = 0, height = 0, channels = 0;
+            job->pixels = { stbi_load(job->path.string().c_str(), &width, &height, &channels, 4), stbi_image_free };
+            job->failed = job->pixels == nullptr || glm::uvec2(width, height) != job->size;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Decoded.push_back(std::move(job));
+    }
+}
+
+void TextureLoader::finish(Job& job, bool success) {
+    if (!success) { WARN("Failed to load texture :: " + job.path.string()); }
+    if (job.callback) { job.callback(job.path, success); }
+    m_Done++;
+}
+
+void TextureLoader::update(void) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        while (!m_Decoded.empty()) {
+            m_Uploading.push_back(std::move(m_Decoded.front()));
+            m_Decoded.pop_front();
+        }
+    }
+
+    size_t used = 0;
+    uint8_t* staging = nullptr;
+    while (!m_Uploading.empty()) {
+        Job& job = *m_Uploading.front();
+        std::shared_ptr<Texture> texture = job.texture.lock();
+        if (texture == nullptr || job.failed) {
+            finish(job, texture != nullptr && !job.failed);
+            m_Uploading.pop_front();
+            continue;
+        }
+
+        // Only whole rows, the rest goes in the next frames
+        const size_t rowBytes = 4ull * job.size.x;
+        const uint32_t numRows = static_cast<uint32_t>(std::min<size_t>(job.size.y - job.nextRow, (m_Budget - used) / rowBytes));
+        if (numRows == 0) { break; }
+
+        if (staging == nullptr) { staging = m_Staging.next<uint8_t>(); }
+        std::memcpy(staging + used, job.pixels.get() + job.nextRow * rowBytes, numRows * rowBytes);
+
+        gl::Consume(gl::Resource::TEXTURE, texture->id(), GL_TEXTURE_UPDATE_BARRIER_BIT);
+        gl::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Staging.id());
+        glTextureSubImage2D(texture->id(), 0, 0, job.nextRow, job.size.x, numRows, GL_RGBA, GL_UNSIGNED_BYTE,
+                            reinterpret_cast<const void*>(m_Staging.offset() + used));
+
+        used += numRows * rowBytes;
+        job.nextRow += numRows;
+
+        if (job.nextRow == job.size.y) {
+            if (texture->specification().autoMipmaps) { texture->generateMipmaps(); }
+            finish(job, true);
+            m_Uploading.pop_front();
+        }
+    }
+
+    if (staging) { gl::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); }
+
+    if (m_Progress) {
+        m_Progress->progress = m_Total == 0 ? 1.0f : float(m_Done) / float(m_Total);
+        if (m_Done == m_Total) { m_Progress = nullptr; }
+    }
+    if (m_Done == m_Total) { m_Total = m_Done = 0; }
+}
+
+void TextureLoader::cancel(void) {
+    std::deque<std::unique_ptr<Job>> canceled;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        canceled.swap(m_Queue);
+        for (auto& job : m_Decoded) { canceled.push_back(std::move(job)); }
+        m_Decoded.clear();
+    }
+    for (auto& job : m_Uploading) { canceled.push_back(std::move(job)); }
+    m_Uploading.clear();
+
+    for (auto& job : canceled) { finish(*job, false); }
+}
+
+size_t TextureLoader::numPending(void) const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Queue.size() + m_Decoded.size() + m_Uploading.size();
+}
+
+} // namespace GRender
@@ -1,4 +1,5 @@
 #include "GRender/utils.h"
+#include "GRender/glState.h"
 
 namespace GRender::utils {
 
@@ -8,6 +9,10 @@ void PerformanceDisplay(bool& view) {
 	ImGui::Begin("Performance", &view);
 	ImGui::Text("FT: %.3f ms", 1000.0f * ImGui::GetIO().DeltaTime);
 	ImGui::Text("FPS: %.0f", ImGui::GetIO().Framerate);
+
+	const gl::Statistics stats = gl::GetStatistics();
+	ImGui::Text("GL binds: %llu issued / %llu skipped", (unsigned long long)stats.issued, (unsigned long long)stats.skipped);
+	ImGui::Text("Memory barriers: %llu", (unsigned long long)stats.barriers);
 	ImGui::Text("Vendor: %s", glGetString(GL_VENDOR));
 	ImGui::Text("Graphics card: %s", glGetString(GL_RENDERER));
 	ImGui::Text("OpenGL version: %s", glGetString(GL_VERSION));